@@ -0,0 +1,884 @@
+// Throughput benchmarks for the CCSDS processing blocks
+//
+// usage: ccsds_bench [name]   (runs all benchmarks if no name is given)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include "ccsds.h"
+#include "reed_solomon.h"
+#include "ccsds_rs_encoder.h"
+#include "ccsds_rs_decoder.h"
+#include "ccsds_batch_decoder.h"
+#include "ccsds_channel_manager.h"
+#include "bitstream.h"
+#include "correlatorl.h"
+#include "frame_ring.h"
+#include "ccsds_pipeline.h"
+#include "viterbi27.h"
+#include "crc16.h"
+#include "transfer_frame.h"
+#include "space_packet.h"
+
+using namespace std;
+
+static unsigned bench_rand()
+{
+    static unsigned state = 12345;
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) & 0xffffff;
+}
+
+// Runs fn repeatedly for about min_seconds and returns the time per call in seconds
+static double time_per_call(const function<void()>& fn, double min_seconds = 0.5)
+{
+    typedef chrono::steady_clock clock;
+    long calls = 0;
+    long batch = 1;
+    auto start = clock::now();
+    double elapsed = 0.0;
+    while (elapsed < min_seconds)
+    {
+        for (long i = 0; i < batch; i++) fn();
+        calls += batch;
+        batch *= 2;
+        elapsed = chrono::duration<double>(clock::now() - start).count();
+    }
+    return elapsed / calls;
+}
+
+// ---------------------------------------------------------------------------
+// RS decoder: errors only vs. errors and erasures
+// ---------------------------------------------------------------------------
+
+struct rs_case
+{
+    const char* name;
+    int n_errors;     // symbol errors per block
+    int n_unreliable; // how many of the errors are flagged as unreliable
+};
+
+static void bench_rs_decode()
+{
+    const int n_blocks = 64;
+    const rs_case cases[] = {
+        {"clean", 0, 0},
+        {"8 errors", 8, 0},
+        {"16 errors", 16, 0},
+        {"24 errors, 16 flagged", 24, 16},
+        {"40 errors, 16 flagged", 40, 16},
+    };
+
+    reed_solomon rs;
+    printf("rs_decode (RS(255,223), dual basis, %i blocks per run)\n", n_blocks);
+    printf("  %-24s %-16s %10s %10s\n", "case", "decoder", "Mbit/s", "decoded");
+
+    for (const rs_case& c : cases)
+    {
+        vector<uint8_t> clean(n_blocks * RS_BLOCK_LEN), received(clean.size()), reliability(clean.size());
+        for (int b = 0; b < n_blocks; b++)
+        {
+            uint8_t* block = &clean[b * RS_BLOCK_LEN];
+            uint8_t* rel = &reliability[b * RS_BLOCK_LEN];
+            for (int j = 0; j < RS_DATA_LEN; j++) block[j] = bench_rand();
+            rs.encode(block, true);
+            memcpy(&received[b * RS_BLOCK_LEN], block, RS_BLOCK_LEN);
+            for (int j = 0; j < RS_BLOCK_LEN; j++) rel[j] = 64 + bench_rand() % 192;
+
+            // distinct error positions, the first n_unreliable get a low reliability
+            int pos[RS_BLOCK_LEN];
+            for (int j = 0; j < RS_BLOCK_LEN; j++) pos[j] = j;
+            for (int e = 0; e < c.n_errors; e++)
+            {
+                int k = e + bench_rand() % (RS_BLOCK_LEN - e);
+                int p = pos[k];
+                pos[k] = pos[e];
+                pos[e] = p;
+                received[b * RS_BLOCK_LEN + p] ^= 1 + bench_rand() % 255;
+                if (e < c.n_unreliable) rel[p] = bench_rand() % 32;
+            }
+        }
+
+        for (int with_erasures = 0; with_erasures < 2; with_erasures++)
+        {
+            vector<uint8_t> work(received.size());
+            int decoded = 0;
+            double t = time_per_call([&]() {
+                memcpy(work.data(), received.data(), work.size());
+                decoded = 0;
+                for (int b = 0; b < n_blocks; b++)
+                {
+                    uint8_t* block = &work[b * RS_BLOCK_LEN];
+                    int16_t r = with_erasures ? rs.decode(block, &reliability[b * RS_BLOCK_LEN], true)
+                                              : rs.decode(block, true);
+                    if (r >= 0 && memcmp(block, &clean[b * RS_BLOCK_LEN], RS_BLOCK_LEN) == 0) decoded++;
+                }
+            });
+            double mbps = n_blocks * RS_DATA_LEN * 8 / t / 1e6;
+            printf("  %-24s %-16s %10.1f %7i/%i\n", c.name, with_erasures ? "errors+erasures" : "errors only",
+                   mbps, decoded, n_blocks);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Frame decoder: sequential vs. batched on the work-stealing pool
+// ---------------------------------------------------------------------------
+
+static void bench_batch_decode()
+{
+    const int n_interleave = 8;
+    const int n_frames = 256;
+    ccsds_rs_encoder encoder(true, true, true, false, false, n_interleave, true);
+    const int frame_len = encoder.total_frame_len();
+    const int data_len = encoder.data_len();
+
+    // every 4th frame noisy, with 8 symbol errors per RS block
+    vector<uint8_t> payloads(n_frames * data_len), frames(n_frames * frame_len);
+    for (int f = 0; f < n_frames; f++)
+    {
+        for (int j = 0; j < data_len; j++) payloads[f * data_len + j] = bench_rand();
+        uint8_t* frame = &frames[f * frame_len];
+        encoder.encode(&payloads[f * data_len], frame);
+        if (f % 4 == 0)
+        {
+            for (int e = 0; e < 8 * n_interleave; e++)
+                frame[SYNC_WORD_LEN + bench_rand() % (frame_len - SYNC_WORD_LEN)] ^= 1 + bench_rand() % 255;
+        }
+    }
+
+    printf("batch_decode (RS(255,223), I=%i, %i frames per run, 1/4 noisy)\n", n_interleave, n_frames);
+    printf("  %-24s %10s %10s\n", "decoder", "Mbit/s", "decoded");
+
+    vector<uint8_t> out(n_frames * data_len);
+    {
+        ccsds_rs_decoder decoder(0, true, true, true, false, false, n_interleave, true);
+        int decoded = 0;
+        double t = time_per_call([&]() {
+            decoded = 0;
+            for (int f = 0; f < n_frames; f++)
+            {
+                int nout = 0;
+                decoder.decode_aligned_bytes(&frames[f * frame_len], frame_len, &out[f * data_len], &nout);
+                if (nout == data_len && memcmp(&out[f * data_len], &payloads[f * data_len], data_len) == 0) decoded++;
+            }
+        });
+        printf("  %-24s %10.1f %7i/%i\n", "sequential", n_frames * data_len * 8 / t / 1e6, decoded, n_frames);
+    }
+
+    int max_threads = max(1u, thread::hardware_concurrency());
+    for (int n_threads = 1; ; n_threads = min(2 * n_threads, max_threads))
+    {
+        ccsds_batch_decoder decoder(true, true, true, n_interleave, true, RS_CODE_255_223, 0, n_threads);
+        vector<ccsds_frame_status> status(n_frames);
+        int decoded = 0;
+        double t = time_per_call([&]() {
+            decoder.decode(frames.data(), nullptr, n_frames, out.data(), status.data());
+        });
+        for (int f = 0; f < n_frames; f++)
+        {
+            if (status[f].decoded && memcmp(&out[f * data_len], &payloads[f * data_len], data_len) == 0) decoded++;
+        }
+        string name = "batch, " + to_string(n_threads) + " threads";
+        printf("  %-24s %10.1f %7i/%i\n", name.c_str(), n_frames * data_len * 8 / t / 1e6, decoded, n_frames);
+        if (n_threads == max_threads) break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Randomizer: per-byte modulo vs. extended sequence, and the whole encoder
+// ---------------------------------------------------------------------------
+
+static void bench_encode()
+{
+    const int n_interleave = 5;
+    ccsds_rs_encoder encoder(true, true, true, false, false, n_interleave, true);
+    const int codeword_len = encoder.codeword_len();
+    vector<uint8_t> codeword(codeword_len), payload(encoder.data_len()), frame(encoder.total_frame_len());
+    for (auto& b : codeword) b = bench_rand();
+    for (auto& b : payload) b = bench_rand();
+
+    printf("encode (RS(255,223), I=%i, %s kernel)\n", n_interleave, randomizer_kernel());
+    printf("  %-24s %10s\n", "", "Mbit/s");
+
+    double t = time_per_call([&]() {
+        for (int i = 0; i < codeword_len; i++) codeword[i] ^= SCRAMBLER_POLY[i % SCRAMBLER_POLY_LEN];
+    });
+    printf("  %-24s %10.1f\n", "randomize, per byte", codeword_len * 8 / t / 1e6);
+    t = time_per_call([&]() { scramble(codeword.data(), codeword_len); });
+    printf("  %-24s %10.1f\n", "randomize, extended seq", codeword_len * 8 / t / 1e6);
+    t = time_per_call([&]() { encoder.encode(payload.data(), frame.data()); });
+    printf("  %-24s %10.1f\n", "encoder", payload.size() * 8 / t / 1e6);
+}
+
+// ---------------------------------------------------------------------------
+// FECF: CRC-16-CCITT bit at a time vs. the selected kernel
+// ---------------------------------------------------------------------------
+
+static void bench_crc()
+{
+    printf("crc (CRC-16-CCITT, %s kernel)\n", crc16_kernel());
+    printf("  %-24s %10s\n", "", "Gbit/s");
+    for (int len : {1115, 1784, 65536})
+    {
+        vector<uint8_t> data(len);
+        for (auto& b : data) b = bench_rand();
+        volatile uint16_t sink = 0;
+        if (len == 1115)
+        {
+            double t = time_per_call([&]() {
+                uint16_t crc = 0xffff;
+                for (int i = 0; i < len; i++)
+                {
+                    crc ^= data[i] << 8;
+                    for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+                }
+                sink = crc;
+            });
+            printf("  %-24s %10.2f\n", "bitwise, 1115 B", len * 8 / t / 1e9);
+        }
+        double t = time_per_call([&]() { sink = crc16_ccitt(data.data(), len); });
+        string name = "crc16_ccitt, " + to_string(len) + " B";
+        printf("  %-24s %10.2f\n", name.c_str(), len * 8 / t / 1e9);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sync search: one bit per byte vs. packed bytes
+// ---------------------------------------------------------------------------
+
+static void bench_asm_search()
+{
+    const int n_interleave = 5;
+    const int n_frames = 32;
+    ccsds_rs_encoder encoder(true, true, true, false, false, n_interleave, true);
+    const int frame_len = encoder.total_frame_len();
+    const int data_len = encoder.data_len();
+
+    // frames separated by gaps of random bits, so most are not byte aligned
+    vector<uint8_t> bits;
+    vector<uint8_t> payloads(n_frames * data_len), frame(frame_len);
+    for (int f = 0; f < n_frames; f++)
+    {
+        int gap = 64 + bench_rand() % 1024;
+        for (int i = 0; i < gap; i++) bits.push_back(bench_rand() & 1);
+        for (int j = 0; j < data_len; j++) payloads[f * data_len + j] = bench_rand();
+        encoder.encode(&payloads[f * data_len], frame.data());
+        for (int i = 0; i < frame_len * 8; i++) bits.push_back((frame[i / 8] >> (7 - i % 8)) & 1);
+    }
+    while (bits.size() % 8) bits.push_back(0);
+    vector<uint8_t> packed(bits.size() / 8);
+    pack_bits(bits.data(), bits.size(), packed.data());
+
+    printf("asm_search (%i frames, I=%i, %zu bits, no RS decoding)\n", n_frames, n_interleave, bits.size());
+    printf("  %-24s %10s %10s\n", "input", "Mbit/s", "frames");
+
+    vector<uint8_t> out(n_frames * data_len);
+    {
+        ccsds_rs_decoder decoder(0, false, true, true, false, false, n_interleave, true);
+        int found = 0;
+        double t = time_per_call([&]() {
+            found = 0;
+            const int chunk = 8 * frame_len;
+            for (size_t pos = 0; pos < bits.size(); pos += chunk)
+            {
+                int nout = 0;
+                decoder.find_asm_and_decode(&bits[pos], min((size_t)chunk, bits.size() - pos), out.data(), &nout);
+                found += nout == data_len && memcmp(out.data(), &payloads[found * data_len], data_len) == 0;
+            }
+        });
+        printf("  %-24s %10.1f %7i/%i\n", "one bit per byte", bits.size() / t / 1e6, found, n_frames);
+    }
+    {
+        ccsds_rs_decoder decoder(0, false, true, true, false, false, n_interleave, true);
+        int nout = 0;
+        double t = time_per_call([&]() {
+            decoder.find_asm_and_decode_packed(packed.data(), packed.size(), out.data(), &nout);
+        });
+        int found = nout == n_frames * data_len && memcmp(out.data(), payloads.data(), nout) == 0 ? n_frames : 0;
+        printf("  %-24s %10.1f %7i/%i\n", "packed", bits.size() / t / 1e6, found, n_frames);
+    }
+    {
+        // codewords assembled and decoded in place in ring slots
+        ccsds_rs_decoder decoder(0, false, true, true, false, false, n_interleave, true);
+        frame_ring ring(n_frames, frame_len);
+        int found = 0;
+        double t = time_per_call([&]() {
+            decoder.find_asm_and_decode_packed(packed.data(), packed.size(), &ring);
+            found = 0;
+            frame_view frame;
+            while (ring.read(&frame))
+            {
+                found += memcmp(frame.data, &payloads[found * data_len], data_len) == 0;
+                ring.release();
+            }
+        });
+        printf("  %-24s %10.1f %7i/%i\n", "packed, frame ring", bits.size() / t / 1e6, found, n_frames);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Correlator: one bit per byte vs. packed bytes
+// ---------------------------------------------------------------------------
+
+static void bench_correlator()
+{
+    const uint64_t asm_word = 0x1acffc1d;
+    const size_t frame_len = 1115;
+    const int n_frames = 32;
+
+    // random frames separated by random gaps, every third one inverted
+    vector<uint8_t> bits;
+    for (int f = 0; f < n_frames; f++)
+    {
+        int gap = bench_rand() % 1024;
+        for (int i = 0; i < gap; i++) bits.push_back(bench_rand() & 1);
+        const uint8_t flip = f % 3 == 0;
+        for (int i = 31; i >= 0; i--) bits.push_back(((asm_word >> i) & 1) ^ flip);
+        for (size_t i = 0; i < frame_len * 8; i++) bits.push_back((bench_rand() & 1) ^ flip);
+    }
+    while (bits.size() % 8) bits.push_back(0);
+    vector<uint8_t> packed(bits.size() / 8);
+    pack_bits(bits.data(), bits.size(), packed.data());
+
+    printf("correlator (%i frames of %zu bytes, %zu bits)\n", n_frames, frame_len, bits.size());
+    printf("  %-24s %10s %10s\n", "input", "Mbit/s", "frames");
+    {
+        ccsds_correlator correlator(asm_word, 0xffffffff, 2, frame_len);
+        vector<uint8_t> frame(frame_len);
+        int found = 0;
+        double t = time_per_call([&]() {
+            found = 0;
+            size_t pos = 0;
+            while (pos < bits.size())
+            {
+                bool ready = false;
+                pos += correlator.process(&bits[pos], bits.size() - pos, frame.data(), &ready);
+                found += ready;
+            }
+        });
+        printf("  %-24s %10.1f %7i/%i\n", "one bit per byte", bits.size() / t / 1e6, found, n_frames);
+    }
+    {
+        ccsds_correlator correlator(asm_word, 0xffffffff, 2, frame_len);
+        int found = 0;
+        double t = time_per_call([&]() {
+            found = correlator.process_packed(packed.data(), packed.size(), [](const uint8_t*, size_t) {});
+        });
+        printf("  %-24s %10.1f %7i/%i\n", "packed", bits.size() / t / 1e6, found, n_frames);
+    }
+    {
+        // the same frames back to back, the synchronizer stays locked
+        vector<uint8_t> cadus;
+        for (int f = 0; f < n_frames; f++)
+        {
+            for (int i = 31; i >= 0; i--) cadus.push_back((asm_word >> i) & 1);
+            for (size_t i = 0; i < frame_len * 8; i++) cadus.push_back(bench_rand() & 1);
+        }
+        vector<uint8_t> packed_cadus(cadus.size() / 8);
+        pack_bits(cadus.data(), cadus.size(), packed_cadus.data());
+
+        ccsds_correlator correlator(asm_word, 0xffffffff, 2, frame_len);
+        int found = 0;
+        double t = time_per_call([&]() {
+            found = correlator.process_packed(packed_cadus.data(), packed_cadus.size(), [](const uint8_t*, size_t) {});
+        });
+        printf("  %-24s %10.1f %7i/%i\n", "packed, no gaps", cadus.size() / t / 1e6, found, n_frames);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Correlator bulk search: every bit offset of a recording
+// ---------------------------------------------------------------------------
+
+static void bench_acquisition()
+{
+    const uint64_t asm_word = 0x1acffc1d;
+    const size_t frame_len = 1115;
+    const size_t n_bytes = 16 << 20;
+
+    // a recording of random bits with frames at random bit offsets, every
+    // third one inverted
+    vector<uint8_t> bits;
+    while (bits.size() < n_bytes * 8)
+    {
+        int gap = bench_rand() % 1024;
+        for (int i = 0; i < gap; i++) bits.push_back(bench_rand() & 1);
+        const uint8_t flip = bits.size() % 3 == 0;
+        for (int i = 31; i >= 0; i--) bits.push_back(((asm_word >> i) & 1) ^ flip);
+        for (size_t i = 0; i < frame_len * 8; i++) bits.push_back(bench_rand() & 1);
+    }
+    bits.resize(n_bytes * 8);
+    vector<uint8_t> packed(n_bytes);
+    pack_bits(bits.data(), bits.size(), packed.data());
+
+    printf("acquisition (%zu MiB recording, all bit offsets)\n", n_bytes >> 20);
+    printf("  %-24s %10s %10s\n", "asm", "Gbit/s", "candidates");
+    for (int threshold : {0, 2, 4})
+    {
+        ccsds_correlator correlator(asm_word, 0xffffffff, threshold, frame_len);
+        size_t found = 0;
+        double t = time_per_call([&]() { found = correlator.find_candidates(packed.data(), packed.size()).size(); });
+        char name[32];
+        snprintf(name, sizeof(name), "32 bits, threshold %i", threshold);
+        printf("  %-24s %10.2f %10zu\n", name, bits.size() / t / 1e9, found);
+    }
+    {
+        // not in the recording, 64-bit lanes
+        ccsds_correlator correlator(0x034776c7272895b0ULL, ~0ULL, 4, frame_len);
+        size_t found = 0;
+        double t = time_per_call([&]() { found = correlator.find_candidates(packed.data(), packed.size()).size(); });
+        printf("  %-24s %10.2f %10zu\n", "64 bits, threshold 4", bits.size() / t / 1e9, found);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Viterbi: the portable K=7 decoder vs. the selected SIMD kernel
+// ---------------------------------------------------------------------------
+
+static void bench_viterbi()
+{
+    const int n_bytes = 32768;
+    vector<uint8_t> data(n_bytes);
+    for (int j = 0; j < n_bytes; j++) data[j] = bench_rand();
+
+    struct code_rate
+    {
+        const char* name;
+        const int* c1;
+        const int* c2;
+        int pattern_len;
+    };
+    const code_rate rates[] = {{"1/2", puncture_C1_12, puncture_C2_12, PUNCTURE_PATTERN_LEN_12},
+                               {"3/4", puncture_C1_34, puncture_C2_34, PUNCTURE_PATTERN_LEN_34}};
+
+    printf("viterbi (K=7, %i B blocks, kernel %s)\n", n_bytes, vitfilt27_kernel());
+    printf("  %-24s %10s %10s %10s %10s %10s\n", "Mbit/s", "generic", "selected", "errors", "block", "errors");
+    v27_block vb;
+    vitfilt27_block_init(&vb, n_bytes * 8);
+    for (const code_rate& rate : rates)
+    {
+        for (float esn0_db : {1.0f, 4.0f})
+        {
+            vector<uint8_t> symbols(n_bytes * 16);
+            unsigned char encstate = 0;
+            symbols.resize(encode27(&encstate, symbols.data(), data.data(), n_bytes, rate.c1, rate.c2,
+                                    rate.pattern_len));
+
+            // BPSK soft symbols, 128 (erasure) where punctured
+            const float sigma = sqrtf(0.5f / powf(10.0f, esn0_db / 10.0f));
+            vector<uint8_t> soft(n_bytes * 16);
+            size_t k = 0;
+            for (int i = 0; i < n_bytes * 8; i++)
+            {
+                const int p = i % rate.pattern_len;
+                for (int c = 0; c < 2; c++)
+                {
+                    if (!(c ? rate.c2[p] : rate.c1[p]))
+                    {
+                        soft[2 * i + c] = 128;
+                        continue;
+                    }
+                    const double u1 = (bench_rand() + 1.0) / 0x1000000, u2 = bench_rand() / (double)0x1000000;
+                    const float x = (symbols[k++] ? 1.0f : -1.0f) + sigma * (float)(sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2));
+                    const int value = int((x + 1.0f) / 2.0f * 255.0f + 0.5f);
+                    soft[2 * i + c] = value < 0 ? 0 : value > 255 ? 255 : value;
+                }
+            }
+
+            vector<uint8_t> out(n_bytes);
+            double t[2];
+            for (int selected = 0; selected < 2; selected++)
+            {
+                v27 vi;
+                memset(&vi, 0, sizeof(v27));
+                vitfilt27_init(&vi);
+                t[selected] = time_per_call([&]() {
+                    if (selected)
+                        vitfilt27_decode(&vi, soft.data(), out.data(), soft.size());
+                    else
+                        vitfilt27_decode_generic(&vi, soft.data(), out.data(), soft.size());
+                });
+            }
+
+            // the output lags the input by MERGEDIST bits
+            v27 vi;
+            memset(&vi, 0, sizeof(v27));
+            vitfilt27_init(&vi);
+            vitfilt27_decode(&vi, soft.data(), out.data(), soft.size());
+            int errors = 0;
+            for (int j = MERGEDIST / 8; j < n_bytes; j++) errors += __builtin_popcount(out[j] ^ data[j - MERGEDIST / 8]);
+
+            // one unterminated block, a single traceback and no lag
+            const double t_block = time_per_call([&]() { vitfilt27_decode_block(&vb, soft.data(), out.data(), n_bytes * 8, -1); });
+            int block_errors = 0;
+            for (int j = 0; j < n_bytes; j++) block_errors += __builtin_popcount(out[j] ^ data[j]);
+
+            char label[32];
+            snprintf(label, sizeof(label), "r=%s Es/N0 %.0f dB", rate.name, esn0_db);
+            printf("  %-24s %10.1f %10.1f %10i %10.1f %10i\n", label, n_bytes * 8 / t[0] / 1e6, n_bytes * 8 / t[1] / 1e6,
+                   errors, n_bytes * 8 / t_block / 1e6, block_errors);
+        }
+    }
+    vitfilt27_block_free(&vb);
+}
+
+// ---------------------------------------------------------------------------
+// Receive chain: soft demod, Viterbi, correlator and RS decoder, on one
+// thread vs. one thread per stage
+// ---------------------------------------------------------------------------
+
+static void bench_pipeline()
+{
+    const int n_interleave = 4;
+    const int n_frames = 256;
+    const size_t chunk = 16384;  // samples per source batch
+    ccsds_rs_encoder encoder(true, true, true, false, false, n_interleave, true);
+    const int frame_len = encoder.total_frame_len();
+    const int data_len = encoder.data_len();
+
+    // CADUs back to back, rate 1/2 coded, BPSK at Es/N0 3 dB
+    vector<uint8_t> payload(data_len), cadus(n_frames * frame_len);
+    for (int f = 0; f < n_frames; f++)
+    {
+        for (int j = 0; j < data_len; j++) payload[j] = bench_rand();
+        encoder.encode(payload.data(), &cadus[f * frame_len]);
+    }
+    const int rate_12[] = {1};
+    vector<uint8_t> symbols(cadus.size() * 16);
+    unsigned char encstate = 0;
+    symbols.resize(encode27(&encstate, symbols.data(), cadus.data(), cadus.size(), rate_12, rate_12, 1));
+    vector<float> samples(symbols.size());
+    const float sigma = sqrtf(0.5f / powf(10.0f, 0.3f));
+    for (size_t i = 0; i < samples.size(); i += 2)
+    {
+        // Box-Muller
+        const double u1 = (bench_rand() + 1.0) / 0x1000000, u2 = bench_rand() / (double)0x1000000;
+        const double r = sqrt(-2.0 * log(u1));
+        samples[i] = (symbols[i] ? -1.0f : 1.0f) + sigma * (float)(r * cos(2 * M_PI * u2));
+        if (i + 1 < samples.size()) samples[i + 1] = (symbols[i + 1] ? -1.0f : 1.0f) + sigma * (float)(r * sin(2 * M_PI * u2));
+    }
+    const double info_bits = (double)n_frames * data_len * 8;
+
+    printf("pipeline (%i CADUs, RS(255,223) I=%i, r=1/2 CC, Es/N0 3 dB, %u cpus)\n", n_frames, n_interleave,
+           thread::hardware_concurrency());
+    printf("  %-24s %10s %10s\n", "chain", "Mbit/s", "decoded");
+    {
+        ccsds_correlator correlator(0x1acffc1d, 0xffffffff, 2, frame_len - SYNC_WORD_LEN);
+        ccsds_rs_decoder decoder(0, true, true, true, false, false, n_interleave, true);
+        stream_pipeline::finish_fn viterbi_finish;
+        stream_pipeline::stage_fn stages[] = {make_soft_demod_stage(rate_12, rate_12, 1),
+                                              make_viterbi_stage(&viterbi_finish),
+                                              make_correlator_stage(&correlator), make_rs_decode_stage(&decoder)};
+        stream_batch a, b;
+        uint32_t decoded = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t pos = 0; pos < samples.size(); pos += chunk)
+        {
+            const size_t n = min(chunk, samples.size() - pos);
+            a.len = 0;
+            memcpy(a.grow(n * sizeof(float)), &samples[pos], n * sizeof(float));
+            a.len = n * sizeof(float);
+            for (auto& stage : stages)
+            {
+                b.len = 0;
+                b.n_items = 0;
+                stage(a, &b);
+                swap(a, b);
+            }
+            decoded += a.n_items;
+        }
+        // the end of the stream held by the Viterbi stage, through the stages after it
+        a.len = 0;
+        a.n_items = 0;
+        viterbi_finish(&a);
+        for (int s = 2; s < 4; s++)
+        {
+            b.len = 0;
+            b.n_items = 0;
+            stages[s](a, &b);
+            swap(a, b);
+        }
+        decoded += a.n_items;
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("  %-24s %10.1f %7u/%i\n", "one thread", info_bits / t / 1e6, decoded, n_frames);
+    }
+    {
+        ccsds_correlator correlator(0x1acffc1d, 0xffffffff, 2, frame_len - SYNC_WORD_LEN);
+        ccsds_rs_decoder decoder(0, true, true, true, false, false, n_interleave, true);
+        stream_pipeline pipeline(8, chunk * sizeof(float));
+        size_t pos = 0;
+        uint32_t decoded = 0;
+        pipeline.set_source("source", [&](stream_batch* out) {
+            if (pos >= samples.size()) return false;
+            const size_t n = min(chunk, samples.size() - pos);
+            memcpy(out->grow(n * sizeof(float)), &samples[pos], n * sizeof(float));
+            out->len = n * sizeof(float);
+            pos += n;
+            return true;
+        });
+        pipeline.add_stage("soft demod", make_soft_demod_stage(rate_12, rate_12, 1));
+        stream_pipeline::finish_fn viterbi_finish;
+        stream_pipeline::stage_fn viterbi = make_viterbi_stage(&viterbi_finish);
+        pipeline.add_stage("viterbi", viterbi, viterbi_finish);
+        pipeline.add_stage("correlator", make_correlator_stage(&correlator));
+        pipeline.add_stage("rs decode", make_rs_decode_stage(&decoder));
+        pipeline.set_sink("sink", [&](const stream_batch& in) { decoded += in.n_items; });
+
+        auto start = chrono::steady_clock::now();
+        pipeline.start();
+        pipeline.wait();
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("  %-24s %10.1f %7u/%i\n", "thread per stage", info_bits / t / 1e6, decoded, n_frames);
+        pipeline.print_metrics(stdout);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Many low-rate channels on one shared decoder pool
+// ---------------------------------------------------------------------------
+
+static void bench_channels()
+{
+    const int n_channels = 1000;
+    const int n_frames = 8;     // per channel
+    const size_t chunk = 96;    // bytes per channel and push
+    ccsds_rs_encoder encoder(true, true, true, false, false, 1, true);
+    const int frame_len = encoder.total_frame_len();
+    const int data_len = encoder.data_len();
+
+    // every channel: CADUs with random gaps, every second frame with 8 symbol errors
+    vector<vector<uint8_t>> streams(n_channels);
+    vector<uint8_t> payload(data_len), frame(frame_len);
+    for (auto& stream : streams)
+    {
+        vector<uint8_t> bits;
+        for (int f = 0; f < n_frames; f++)
+        {
+            int gap = bench_rand() % 256;
+            for (int i = 0; i < gap; i++) bits.push_back(bench_rand() & 1);
+            for (int j = 0; j < data_len; j++) payload[j] = bench_rand();
+            encoder.encode(payload.data(), frame.data());
+            if (f % 2) for (int e = 0; e < 8; e++) frame[SYNC_WORD_LEN + bench_rand() % (frame_len - SYNC_WORD_LEN)] ^= 1 + bench_rand() % 255;
+            for (int i = 0; i < frame_len * 8; i++) bits.push_back((frame[i / 8] >> (7 - i % 8)) & 1);
+        }
+        while (bits.size() % 8) bits.push_back(0);
+        stream.resize(bits.size() / 8);
+        pack_bits(bits.data(), bits.size(), stream.data());
+    }
+    size_t total_bytes = 0, max_bytes = 0;
+    for (auto& stream : streams)
+    {
+        total_bytes += stream.size();
+        max_bytes = max(max_bytes, stream.size());
+    }
+
+    printf("channels (%i channels, RS(255,223) I=1, %zu byte pushes, %u cpus)\n", n_channels, chunk,
+           thread::hardware_concurrency());
+    printf("  state per channel: ~%zu bytes (a ccsds_rs_decoder is %zu)\n",
+           sizeof(ccsds_frame_sync) + encoder.codeword_len() + 64, sizeof(ccsds_rs_decoder));
+    printf("  %-24s %10s %10s\n", "input", "Mbit/s", "decoded");
+    for (bool batched : {false, true})
+    {
+        uint64_t decoded = 0;
+        ccsds_channel_manager manager([&](int, const uint8_t*, size_t, const ccsds_frame_status& st) { decoded += st.decoded; });
+        ccsds_channel_manager::channel_config config;
+        for (int c = 0; c < n_channels; c++) manager.add_channel(config);
+
+        vector<ccsds_channel_manager::channel_input> inputs;
+        auto start = chrono::steady_clock::now();
+        for (size_t pos = 0; pos < max_bytes; pos += chunk)
+        {
+            inputs.clear();
+            for (int c = 0; c < n_channels; c++)
+            {
+                if (pos >= streams[c].size()) continue;
+                const size_t n = min(chunk, streams[c].size() - pos);
+                if (batched)
+                    inputs.push_back({c, &streams[c][pos], n});
+                else
+                    manager.push(c, &streams[c][pos], n);
+            }
+            if (batched) manager.push(inputs.data(), inputs.size());
+        }
+        manager.flush();
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("  %-24s %10.1f %6llu/%i\n", batched ? "push(inputs)" : "push(channel)", total_bytes * 8 / t / 1e6,
+               (unsigned long long)decoded, n_channels * n_frames);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Transfer frames: header parsing and VC demultiplexing
+// ---------------------------------------------------------------------------
+
+static void bench_demux()
+{
+    const int frame_len = 1115;
+    const int n_frames = 4096;
+    // TM frames on VCs 0..3, every 8th an idle frame on VC 7
+    vector<uint8_t> frames((size_t)n_frames * frame_len);
+    int vc_count[8] = {0};
+    for (int f = 0; f < n_frames; f++)
+    {
+        uint8_t* p = &frames[(size_t)f * frame_len];
+        for (int j = 0; j < frame_len; j++) p[j] = bench_rand();
+        const int vcid = f % 8 == 7 ? 7 : f % 4;
+        const int fhp = vcid == 7 ? TF_FHP_IDLE : f % 100;
+        p[0] = 0x12 >> 4;
+        p[1] = (0x12 & 0xf) << 4 | vcid << 1;
+        p[2] = f;
+        p[3] = vc_count[vcid]++;
+        p[4] = fhp >> 8;
+        p[5] = fhp & 0xff;
+    }
+
+    printf("demux (TM, %i B frames, 4 VCs + idle)\n", frame_len);
+    printf("  %-24s %10s %10s\n", "", "Mframe/s", "Gbit/s");
+    transfer_frame_config config;
+    vc_demux demux(config);
+    size_t n_starts = 0;  // frames with a packet start, keeps the pops alive
+    double t = time_per_call([&]() {
+        demux.push_frames(frames.data(), frames.size(), frame_len);
+        transfer_frame_view view;
+        for (int vcid = 0; vcid < 4; vcid++)
+        {
+            while (demux.pop(vcid, &view)) n_starts += view.first_header_pointer() != TF_FHP_NO_PACKET;
+        }
+    });
+    printf("  %-24s %10.1f %10.1f\n", "push_frames + pop", n_frames / t / 1e6, frames.size() * 8 / t / 1e9);
+}
+
+// ---------------------------------------------------------------------------
+// Space Packets: extraction from the packet zones of TM frames
+// ---------------------------------------------------------------------------
+
+static void bench_packets()
+{
+    const int frame_len = 1115;
+    const int zone_len = frame_len - TF_PRIMARY_HEADER_LEN;
+    const int n_frames = 4096;
+    // back to back packets of 8..2047 bytes on VC 0, cut into frames
+    vector<uint8_t> stream;
+    vector<int> starts;
+    while (stream.size() < (size_t)n_frames * zone_len)
+    {
+        const int len = 8 + bench_rand() % 2040;
+        starts.push_back(stream.size());
+        const size_t pos = stream.size();
+        stream.resize(pos + len);
+        for (int j = 0; j < len; j++) stream[pos + j] = bench_rand();
+        stream[pos] = 0x08 | (starts.size() % 0x7ff) >> 8;
+        stream[pos + 1] = starts.size() % 0x7ff;
+        stream[pos + 4] = (len - SP_PRIMARY_HEADER_LEN - 1) >> 8;
+        stream[pos + 5] = (len - SP_PRIMARY_HEADER_LEN - 1) & 0xff;
+    }
+    vector<uint8_t> frames((size_t)n_frames * frame_len);
+    vector<transfer_frame_view> views(n_frames);
+    transfer_frame_config config;
+    size_t next_start = 0;
+    for (int f = 0; f < n_frames; f++)
+    {
+        uint8_t* p = &frames[(size_t)f * frame_len];
+        const size_t zone = (size_t)f * zone_len;
+        while (next_start < starts.size() && (size_t)starts[next_start] < zone) next_start++;
+        const int fhp = (size_t)starts[next_start] < zone + zone_len ? starts[next_start] - zone : TF_FHP_NO_PACKET;
+        p[0] = 0x12 >> 4;
+        p[1] = (0x12 & 0xf) << 4;
+        p[2] = f;
+        p[3] = f;
+        p[4] = fhp >> 8;
+        p[5] = fhp & 0xff;
+        memcpy(&p[TF_PRIMARY_HEADER_LEN], &stream[zone], zone_len);
+        parse_transfer_frame(p, frame_len, config, &views[f]);
+    }
+
+    printf("packets (TM, %i B frames, 8..2047 B packets)\n", frame_len);
+    printf("  %-24s %10s %10s\n", "", "Mpacket/s", "Gbit/s");
+    size_t n_packets = 0;
+    const double bits = (double)n_frames * zone_len * 8;
+
+    // every packet copied into a buffer of its own
+    {
+        packet_extractor extractor;
+        vector<space_packet> packets;
+        vector<vector<uint8_t>> copies;
+        double t = time_per_call([&]() {
+            copies.clear();
+            for (const transfer_frame_view& view : views)
+            {
+                packets.clear();
+                extractor.extract(view, &packets);
+                for (const space_packet& packet : packets)
+                {
+                    copies.emplace_back(packet.data, packet.data + packet.len);
+                    extractor.release(packet);
+                }
+            }
+            n_packets = copies.size();
+        });
+        printf("  %-24s %10.2f %10.1f\n", "copy per packet", n_packets / t / 1e6, bits / t / 1e9);
+    }
+    {
+        packet_extractor extractor;
+        vector<space_packet> packets;
+        size_t apids = 0;
+        double t = time_per_call([&]() {
+            n_packets = 0;
+            for (const transfer_frame_view& view : views)
+            {
+                packets.clear();
+                n_packets += extractor.extract(view, &packets);
+                for (const space_packet& packet : packets)
+                {
+                    apids += packet.apid();
+                    extractor.release(packet);
+                }
+            }
+        });
+        printf("  %-24s %10.2f %10.1f\n", "views + packet_pool", n_packets / t / 1e6, bits / t / 1e9);
+        printf("  %.0f%% of the packets span frames\n",
+               100.0 * extractor.counters().reassembled / (extractor.counters().packets + extractor.counters().reassembled));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    struct benchmark
+    {
+        const char* name;
+        void (*fn)();
+    };
+    const benchmark benchmarks[] = {
+        {"rs_decode", bench_rs_decode},
+        {"batch_decode", bench_batch_decode},
+        {"encode", bench_encode},
+        {"crc", bench_crc},
+        {"asm_search", bench_asm_search},
+        {"correlator", bench_correlator},
+        {"acquisition", bench_acquisition},
+        {"viterbi", bench_viterbi},
+        {"pipeline", bench_pipeline},
+        {"channels", bench_channels},
+        {"demux", bench_demux},
+        {"packets", bench_packets},
+    };
+
+    string selected = argc > 1 ? argv[1] : "";
+    for (const benchmark& b : benchmarks)
+    {
+        if (selected.empty() || selected == b.name)
+        {
+            b.fn();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,431 @@
+#include "bitstream.h"
+
+#include <algorithm>
+
+typedef unsigned __int128 window_t;
+
+typedef size_t (*find_sync_fn)(const uint8_t *, size_t, size_t, uint32_t, int, uint64_t *, int *);
+typedef size_t (*find_sync_masked_fn)(const uint8_t *, size_t, size_t, uint64_t, uint64_t, int, bool, window_t *,
+                                      int *, bool *);
+
+// Every byte is compared at offsets 7 (the sync word ends with the byte's
+// first bit) down to 0 (it ends with the byte), so the earliest match wins.
+// The *_body loops run once the window is long enough for every offset.
+
+static inline __attribute__((always_inline))
+size_t find_sync_body(const uint8_t *in, size_t i, size_t n_bytes, uint32_t sync_word, int threshold,
+                      uint64_t *window, int *offset)
+{
+    uint64_t w = *window;
+    for (; i < n_bytes; i++)
+    {
+        w = (w << 8) | in[i];
+        for (int o = 7; o >= 0; o--)
+        {
+            if (__builtin_popcount((uint32_t)(w >> o) ^ sync_word) <= threshold)
+            {
+                *window = w;
+                *offset = o;
+                return i;
+            }
+        }
+    }
+    *window = w;
+    return n_bytes;
+}
+
+static inline __attribute__((always_inline))
+size_t find_sync_masked_body(const uint8_t *in, size_t i, size_t n_bytes, uint64_t sync_word, uint64_t mask,
+                             int threshold, bool match_inverted, window_t *window, int *offset, bool *inverted)
+{
+    const int mask_bits = __builtin_popcountll(mask);
+    window_t w = *window;
+    for (; i < n_bytes; i++)
+    {
+        w = (w << 8) | in[i];
+        for (int o = 7; o >= 0; o--)
+        {
+            const int wrong_bits = __builtin_popcountll(((uint64_t)(w >> o) ^ sync_word) & mask);
+            if (wrong_bits <= threshold || (match_inverted && mask_bits - wrong_bits <= threshold))
+            {
+                *window = w;
+                *offset = o;
+                *inverted = wrong_bits > threshold;
+                return i;
+            }
+        }
+    }
+    *window = w;
+    return n_bytes;
+}
+
+static size_t find_sync_generic(const uint8_t *in, size_t i, size_t n_bytes, uint32_t sync_word, int threshold,
+                                uint64_t *window, int *offset)
+{
+    return find_sync_body(in, i, n_bytes, sync_word, threshold, window, offset);
+}
+
+static size_t find_sync_masked_generic(const uint8_t *in, size_t i, size_t n_bytes, uint64_t sync_word,
+                                       uint64_t mask, int threshold, bool match_inverted, window_t *window,
+                                       int *offset, bool *inverted)
+{
+    return find_sync_masked_body(in, i, n_bytes, sync_word, mask, threshold, match_inverted, window, offset,
+                                 inverted);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BITSTREAM_X86
+#include <immintrin.h>
+
+__attribute__((target("popcnt")))
+static size_t find_sync_popcnt(const uint8_t *in, size_t i, size_t n_bytes, uint32_t sync_word, int threshold,
+                               uint64_t *window, int *offset)
+{
+    return find_sync_body(in, i, n_bytes, sync_word, threshold, window, offset);
+}
+
+__attribute__((target("popcnt")))
+static size_t find_sync_masked_popcnt(const uint8_t *in, size_t i, size_t n_bytes, uint64_t sync_word,
+                                      uint64_t mask, int threshold, bool match_inverted, window_t *window,
+                                      int *offset, bool *inverted)
+{
+    return find_sync_masked_body(in, i, n_bytes, sync_word, mask, threshold, match_inverted, window, offset,
+                                 inverted);
+}
+#endif
+
+static find_sync_fn select_find_sync()
+{
+#ifdef BITSTREAM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt"))
+    {
+        return find_sync_popcnt;
+    }
+#endif
+    return find_sync_generic;
+}
+
+static find_sync_masked_fn select_find_sync_masked()
+{
+#ifdef BITSTREAM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt"))
+    {
+        return find_sync_masked_popcnt;
+    }
+#endif
+    return find_sync_masked_generic;
+}
+
+// shifts the last n_bits bits of byte into the window
+static void shift_window(sync_window *window, uint8_t byte, int n_bits, int max_valid)
+{
+    window->bits_hi = (window->bits_hi << n_bits) | (window->bits >> (64 - n_bits));
+    window->bits = (window->bits << n_bits) | (byte & (0xff >> (8 - n_bits)));
+    window->n_valid = window->n_valid + n_bits < max_valid ? window->n_valid + n_bits : max_valid;
+}
+
+bool find_sync_word(const uint8_t *in, size_t n_bytes, size_t *pos, uint32_t sync_word, int threshold,
+                    sync_window *window)
+{
+    // the first bits of a search, until the word fits in the window at every
+    // offset, and a search resumed in the middle of a byte
+    size_t i = *pos >> 3;
+    int n_bits = 8 - (*pos & 7);
+    for (; i < n_bytes && (window->n_valid < 32 + 7 || n_bits < 8); i++, n_bits = 8)
+    {
+        shift_window(window, in[i], n_bits, 64);
+        for (int o = n_bits - 1; o >= 0; o--)
+        {
+            if (window->n_valid - o >= 32 &&
+                __builtin_popcount((uint32_t)(window->bits >> o) ^ sync_word) <= threshold)
+            {
+                *pos = (i + 1) * 8 - o;
+                return true;
+            }
+        }
+    }
+
+    static const find_sync_fn find_sync = select_find_sync();
+
+    *pos = n_bytes * 8;
+    if (i >= n_bytes) return false;
+
+    int offset;
+    i = find_sync(in, i, n_bytes, sync_word, threshold, &window->bits, &offset);
+    if (i == n_bytes) return false;
+    *pos = (i + 1) * 8 - offset;
+    return true;
+}
+
+bool find_sync_word_masked(const uint8_t *in, size_t n_bytes, size_t *pos, uint64_t sync_word, uint64_t mask,
+                           int threshold, bool match_inverted, sync_window *window, bool *inverted)
+{
+    const int sync_len = 64 - __builtin_clzll(mask);
+    const int mask_bits = __builtin_popcountll(mask);
+
+    // see find_sync_word()
+    size_t i = *pos >> 3;
+    int n_bits = 8 - (*pos & 7);
+    for (; i < n_bytes && (window->n_valid < sync_len + 7 || n_bits < 8); i++, n_bits = 8)
+    {
+        shift_window(window, in[i], n_bits, 128);
+        for (int o = n_bits - 1; o >= 0; o--)
+        {
+            window_t w = ((window_t)window->bits_hi << 64) | window->bits;
+            const int wrong_bits = __builtin_popcountll(((uint64_t)(w >> o) ^ sync_word) & mask);
+            if (window->n_valid - o >= sync_len &&
+                (wrong_bits <= threshold || (match_inverted && mask_bits - wrong_bits <= threshold)))
+            {
+                *inverted = wrong_bits > threshold;
+                *pos = (i + 1) * 8 - o;
+                return true;
+            }
+        }
+    }
+
+    static const find_sync_masked_fn find_sync = select_find_sync_masked();
+
+    *pos = n_bytes * 8;
+    if (i >= n_bytes) return false;
+
+    int offset;
+    window_t w = ((window_t)window->bits_hi << 64) | window->bits;
+    i = find_sync(in, i, n_bytes, sync_word, mask, threshold, match_inverted, &w, &offset, inverted);
+    window->bits = (uint64_t)w;
+    window->bits_hi = (uint64_t)(w >> 64);
+    if (i == n_bytes) return false;
+    *pos = (i + 1) * 8 - offset;
+    return true;
+}
+
+// parameters of find_sync_candidates()
+struct candidate_search
+{
+    uint64_t sync_word;
+    uint64_t mask;
+    int threshold;
+    int mask_bits;
+    bool match_inverted;
+    int64_t min_pos;  // sync word ends reported
+    int64_t max_pos;
+};
+
+typedef size_t (*scan_blocks_fn)(const uint8_t *, size_t, const candidate_search &, std::vector<sync_candidate> *);
+
+// The bulk search runs over blocks of 16 bytes: the 64 windows of 64 bits
+// that start at bit o of byte k, k and o < 8. start is the stream position
+// of the block's first bit, negative for the zero-prefixed head of a buffer.
+
+static inline __attribute__((always_inline))
+void scan_block_body(const uint8_t *p, int64_t start, const candidate_search &s, std::vector<sync_candidate> *out)
+{
+    for (int k = 0; k < 8; k++)
+    {
+        const uint64_t a = load_be64(&p[k]);
+        for (int o = 0; o < 8; o++)
+        {
+            const uint64_t w = (a << o) | (p[k + 8] >> (8 - o));
+            const int wrong_bits = __builtin_popcountll((w ^ s.sync_word) & s.mask);
+            if (wrong_bits > s.threshold && !(s.match_inverted && s.mask_bits - wrong_bits <= s.threshold))
+            {
+                continue;
+            }
+            const int64_t pos = start + 8 * k + o + 64;
+            if (pos < s.min_pos || pos > s.max_pos) continue;
+            const bool inverted = wrong_bits > s.threshold;
+            out->push_back({(size_t)pos, inverted ? s.mask_bits - wrong_bits : wrong_bits, inverted});
+        }
+    }
+}
+
+static inline __attribute__((always_inline))
+size_t scan_blocks_body(const uint8_t *in, size_t n_bytes, const candidate_search &s, std::vector<sync_candidate> *out)
+{
+    size_t i = 0;
+    for (; i + 16 <= n_bytes; i += 8)
+    {
+        scan_block_body(&in[i], 8 * (int64_t)i, s, out);
+    }
+    return i;
+}
+
+static void scan_block_generic(const uint8_t *p, int64_t start, const candidate_search &s,
+                               std::vector<sync_candidate> *out)
+{
+    scan_block_body(p, start, s, out);
+}
+
+static size_t scan_blocks_generic(const uint8_t *in, size_t n_bytes, const candidate_search &s,
+                                  std::vector<sync_candidate> *out)
+{
+    return scan_blocks_body(in, n_bytes, s, out);
+}
+
+#ifdef BITSTREAM_X86
+__attribute__((target("popcnt")))
+static size_t scan_blocks_popcnt(const uint8_t *in, size_t n_bytes, const candidate_search &s,
+                                 std::vector<sync_candidate> *out)
+{
+    return scan_blocks_body(in, n_bytes, s, out);
+}
+
+// Eight windows per step and vector: lane k of a holds the 64 bits from
+// byte k (PSHUFB byte reversal of the block broadcast to both halves), lane
+// k of next the byte after them. The masked distances are counted with
+// nibble lookups and PSADBW; a block with any lane within the threshold, of
+// either polarity, is rescanned with scan_block_body() for the exact matches.
+__attribute__((target("avx2,popcnt")))
+static size_t scan_blocks_avx2(const uint8_t *in, size_t n_bytes, const candidate_search &s,
+                               std::vector<sync_candidate> *out)
+{
+    const __m256i first_words = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 8, 7, 6, 5, 4, 3, 2, 1,
+                                                  9, 8, 7, 6, 5, 4, 3, 2, 10, 9, 8, 7, 6, 5, 4, 3);
+    const __m256i last_words = _mm256_setr_epi8(11, 10, 9, 8, 7, 6, 5, 4, 12, 11, 10, 9, 8, 7, 6, 5,
+                                                13, 12, 11, 10, 9, 8, 7, 6, 14, 13, 12, 11, 10, 9, 8, 7);
+    const __m256i first_next = _mm256_setr_epi8(8, -1, -1, -1, -1, -1, -1, -1, 9, -1, -1, -1, -1, -1, -1, -1,
+                                                10, -1, -1, -1, -1, -1, -1, -1, 11, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i last_next = _mm256_setr_epi8(12, -1, -1, -1, -1, -1, -1, -1, 13, -1, -1, -1, -1, -1, -1, -1,
+                                               14, -1, -1, -1, -1, -1, -1, -1, 15, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i bit_count = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i sync_word = _mm256_set1_epi64x(s.sync_word);
+    const __m256i mask = _mm256_set1_epi64x(s.mask);
+    // distance < below or distance > above is a match
+    const __m256i below = _mm256_set1_epi64x(s.threshold + 1);
+    const __m256i above = _mm256_set1_epi64x(s.match_inverted ? s.mask_bits - s.threshold - 1 : 64);
+
+    size_t i = 0;
+    for (; i + 16 <= n_bytes; i += 8)
+    {
+        const __m256i block = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&in[i]));
+        const __m256i a[2] = {_mm256_shuffle_epi8(block, first_words), _mm256_shuffle_epi8(block, last_words)};
+        const __m256i next[2] = {_mm256_shuffle_epi8(block, first_next), _mm256_shuffle_epi8(block, last_next)};
+
+        __m256i match = zero;
+#pragma GCC unroll 8
+        for (int o = 0; o < 8; o++)
+        {
+            for (int h = 0; h < 2; h++)
+            {
+                const __m256i w = _mm256_or_si256(_mm256_slli_epi64(a[h], o), _mm256_srli_epi64(next[h], 8 - o));
+                const __m256i x = _mm256_and_si256(_mm256_xor_si256(w, sync_word), mask);
+                const __m256i lo = _mm256_and_si256(x, nibble);
+                const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+                const __m256i d = _mm256_sad_epu8(
+                    _mm256_add_epi8(_mm256_shuffle_epi8(bit_count, lo), _mm256_shuffle_epi8(bit_count, hi)), zero);
+                match = _mm256_or_si256(match, _mm256_or_si256(_mm256_cmpgt_epi64(below, d),
+                                                               _mm256_cmpgt_epi64(d, above)));
+            }
+        }
+        if (!_mm256_testz_si256(match, match))
+        {
+            scan_block_body(&in[i], 8 * (int64_t)i, s, out);
+        }
+    }
+    return i;
+}
+
+// Same as scan_blocks_avx2() with the last 32 bits of every window in 32-bit
+// lanes, eight windows per vector, for a mask of at most 32 bits.
+__attribute__((target("avx2,popcnt")))
+static size_t scan_blocks_avx2_short(const uint8_t *in, size_t n_bytes, const candidate_search &s,
+                                     std::vector<sync_candidate> *out)
+{
+    const __m256i words = _mm256_setr_epi8(7, 6, 5, 4, 8, 7, 6, 5, 9, 8, 7, 6, 10, 9, 8, 7,
+                                           11, 10, 9, 8, 12, 11, 10, 9, 13, 12, 11, 10, 14, 13, 12, 11);
+    const __m256i next_bytes = _mm256_setr_epi8(8, -1, -1, -1, 9, -1, -1, -1, 10, -1, -1, -1, 11, -1, -1, -1,
+                                                12, -1, -1, -1, 13, -1, -1, -1, 14, -1, -1, -1, 15, -1, -1, -1);
+    const __m256i bit_count = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i ones8 = _mm256_set1_epi8(1);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+    const __m256i sync_word = _mm256_set1_epi32((uint32_t)s.sync_word);
+    const __m256i mask = _mm256_set1_epi32((uint32_t)s.mask);
+    const __m256i below = _mm256_set1_epi32(s.threshold + 1);
+    const __m256i above = _mm256_set1_epi32(s.match_inverted ? s.mask_bits - s.threshold - 1 : 32);
+
+    size_t i = 0;
+    for (; i + 16 <= n_bytes; i += 8)
+    {
+        const __m256i block = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&in[i]));
+        const __m256i a = _mm256_shuffle_epi8(block, words);
+        const __m256i next = _mm256_shuffle_epi8(block, next_bytes);
+
+        __m256i match = _mm256_setzero_si256();
+#pragma GCC unroll 8
+        for (int o = 0; o < 8; o++)
+        {
+            const __m256i w = _mm256_or_si256(_mm256_slli_epi32(a, o), _mm256_srli_epi32(next, 8 - o));
+            const __m256i x = _mm256_and_si256(_mm256_xor_si256(w, sync_word), mask);
+            const __m256i lo = _mm256_and_si256(x, nibble);
+            const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+            const __m256i c = _mm256_add_epi8(_mm256_shuffle_epi8(bit_count, lo), _mm256_shuffle_epi8(bit_count, hi));
+            const __m256i d = _mm256_madd_epi16(_mm256_maddubs_epi16(c, ones8), ones16);
+            match = _mm256_or_si256(match, _mm256_or_si256(_mm256_cmpgt_epi32(below, d),
+                                                           _mm256_cmpgt_epi32(d, above)));
+        }
+        if (!_mm256_testz_si256(match, match))
+        {
+            scan_block_body(&in[i], 8 * (int64_t)i, s, out);
+        }
+    }
+    return i;
+}
+#endif
+
+// a mask of up to 32 bits selects scan_blocks_avx2_short()
+static scan_blocks_fn select_scan_blocks(bool short_word)
+{
+#ifdef BITSTREAM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    {
+        return short_word ? scan_blocks_avx2_short : scan_blocks_avx2;
+    }
+    if (__builtin_cpu_supports("popcnt"))
+    {
+        return scan_blocks_popcnt;
+    }
+#endif
+    return scan_blocks_generic;
+}
+
+size_t find_sync_candidates(const uint8_t *in, size_t n_bytes, uint64_t sync_word, uint64_t mask, int threshold,
+                            bool match_inverted, std::vector<sync_candidate> *candidates)
+{
+    const candidate_search s = {sync_word,
+                                mask,
+                                threshold,
+                                __builtin_popcountll(mask),
+                                match_inverted,
+                                64 - __builtin_clzll(mask),
+                                8 * (int64_t)n_bytes};
+    const size_t first = candidates->size();
+
+    // sync words ending in the first 63 bits, windows zero-filled in front
+    uint8_t block[16] = {0};
+    memcpy(&block[8], in, std::min<size_t>(n_bytes, 8));
+    scan_block_generic(block, -64, s, candidates);
+
+    static const scan_blocks_fn scan_blocks = select_scan_blocks(false);
+    static const scan_blocks_fn scan_blocks_short = select_scan_blocks(true);
+    size_t i = (mask >> 32 ? scan_blocks : scan_blocks_short)(in, n_bytes, s, candidates);
+
+    // the last blocks, zero-filled behind the buffer
+    for (; i + 8 <= n_bytes; i += 8)
+    {
+        memset(block, 0, sizeof(block));
+        memcpy(block, &in[i], std::min<size_t>(n_bytes - i, 16));
+        scan_block_generic(block, 8 * (int64_t)i, s, candidates);
+    }
+
+    std::sort(candidates->begin() + first, candidates->end(), [](const sync_candidate &a, const sync_candidate &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.pos < b.pos;
+    });
+    return candidates->size() - first;
+}
@@ -0,0 +1,164 @@
+#ifndef INCLUDED_BITSTREAM_H
+#define INCLUDED_BITSTREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+// Helpers for packed bitstreams: 8 bits per byte, most significant bit first,
+// bit i of the stream is bit 7 - i % 8 of byte i / 8.
+
+inline uint64_t load_be64(const uint8_t *p)
+{
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return __builtin_bswap64(w);
+}
+
+inline void store_be64(uint8_t *p, uint64_t w)
+{
+    w = __builtin_bswap64(w);
+    memcpy(p, &w, sizeof(w));
+}
+
+inline int get_bit(const uint8_t *in, size_t bit)
+{
+    return (in[bit >> 3] >> (7 - (bit & 7))) & 1;
+}
+
+/**
+ * Copies n_bytes bytes starting at an arbitrary bit offset of in to out,
+ * eight output bytes per 64-bit shift-and-or. Reads in[bit_offset / 8]
+ * up to the byte holding bit bit_offset + 8 * n_bytes - 1.
+ */
+inline void extract_bits(const uint8_t *in, size_t bit_offset, uint8_t *out, size_t n_bytes)
+{
+    const uint8_t *p = &in[bit_offset >> 3];
+    const int shift = bit_offset & 7;
+    if (shift == 0)
+    {
+        memcpy(out, p, n_bytes);
+        return;
+    }
+
+    size_t i = 0;
+    for (; i + 8 <= n_bytes; i += 8)
+    {
+        store_be64(&out[i], (load_be64(&p[i]) << shift) | (p[i + 8] >> (8 - shift)));
+    }
+    for (; i < n_bytes; i++)
+    {
+        out[i] = (p[i] << shift) | (p[i + 1] >> (8 - shift));
+    }
+}
+
+/**
+ * Packs n_bits bits, one per input byte (LSB), into (n_bits + 7) / 8 bytes.
+ */
+inline void pack_bits(const uint8_t *bits, size_t n_bits, uint8_t *out)
+{
+    memset(out, 0, (n_bits + 7) / 8);
+    for (size_t i = 0; i < n_bits; i++)
+    {
+        out[i >> 3] |= (bits[i] & 1) << (7 - (i & 7));
+    }
+}
+
+/**
+ * Appends the bits of a packed buffer from bit pos on to out[*n_out..len),
+ * a byte at a time with extract_bits(). Bits that don't fill a whole byte
+ * at the end of the buffer are kept in reg/reg_bits and start the next
+ * byte on the following call.
+ *
+ * @return The bit following the last one consumed
+ */
+inline size_t append_bits(const uint8_t *in, size_t n_bits, size_t pos, uint8_t *out, size_t *n_out, size_t len,
+                          uint32_t *reg, int *reg_bits)
+{
+    if (*reg_bits > 0)
+    {
+        while (*reg_bits < 8 && pos < n_bits)
+        {
+            *reg = (*reg << 1) | get_bit(in, pos++);
+            (*reg_bits)++;
+        }
+        if (*reg_bits < 8) return pos;
+        out[(*n_out)++] = *reg;
+        *reg_bits = 0;
+    }
+
+    size_t n = (n_bits - pos) / 8;
+    if (n > len - *n_out) n = len - *n_out;
+    extract_bits(in, pos, &out[*n_out], n);
+    *n_out += n;
+    pos += 8 * n;
+
+    // fewer than 8 bits left in the buffer
+    while (*n_out < len && pos < n_bits)
+    {
+        *reg = (*reg << 1) | get_bit(in, pos++);
+        (*reg_bits)++;
+    }
+    return pos;
+}
+
+// last bits of a packed stream being searched for a sync word
+struct sync_window
+{
+    uint64_t bits;     // most recent bit in the LSB
+    uint64_t bits_hi;  // the 64 bits before, find_sync_word_masked() only
+    int n_valid;       // bits of the window that belong to the search
+};
+
+/**
+ * Searches a packed bitstream for a 32-bit sync word: slides a 64-bit
+ * window a byte at a time and compares the word at all 8 bit offsets of the
+ * new byte (popcount of the difference, hardware popcnt when the CPU has it).
+ *
+ * @param in        Packed input bytes
+ * @param n_bytes   Number of input bytes
+ * @param pos       In: first bit of in that belongs to the search. Out: the
+ *                  bit following the match, or n_bytes * 8
+ * @param sync_word Word to search for
+ * @param threshold Maximum number of differing bits
+ * @param window    Search state, carried from call to call; zero it to
+ *                  start a new search
+ * @return          True if the sync word was found
+ */
+bool find_sync_word(const uint8_t *in, size_t n_bytes, size_t *pos, uint32_t sync_word, int threshold,
+                    sync_window *window);
+
+/**
+ * Same as find_sync_word() for a sync word of up to 64 bits, compared
+ * where mask (non-zero) is set, that may also be received inverted (BPSK
+ * phase ambiguity).
+ *
+ * @param match_inverted Also accept the complement of sync_word
+ * @param inverted       Output, the match found is the complement
+ */
+bool find_sync_word_masked(const uint8_t *in, size_t n_bytes, size_t *pos, uint64_t sync_word, uint64_t mask,
+                           int threshold, bool match_inverted, sync_window *window, bool *inverted);
+
+// a match of find_sync_candidates()
+struct sync_candidate
+{
+    size_t pos;     // bit following the sync word
+    int distance;   // differing bits, to the complement if inverted
+    bool inverted;
+};
+
+/**
+ * Bulk search for initial acquisition: compares the masked sync word (and
+ * its complement if match_inverted) at every bit offset of a whole buffer,
+ * 64 offsets per step with AVX2 when the CPU has it. Sync words that start
+ * before the buffer or end after it are not reported.
+ *
+ * @param candidates Output, every offset within threshold, appended sorted
+ *                   by distance, then by position
+ * @return           Number of candidates appended
+ */
+size_t find_sync_candidates(const uint8_t *in, size_t n_bytes, uint64_t sync_word, uint64_t mask, int threshold,
+                            bool match_inverted, std::vector<sync_candidate> *candidates);
+
+#endif /* INCLUDED_BITSTREAM_H */
@@ -15,9 +15,15 @@
  */
 //#include <stdio.h>
 #include <limits.h>
+#include <stdlib.h>
 #include "viterbi27.h"
 #include <stdio.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VITERBI27_X86 1
+#include <immintrin.h>
+#endif
+
 
 
 
@@ -111,7 +117,10 @@
 
 int mettab[2][256];
 
-void vitfilt27_init(v27 *vi)
+/* start metric of the states other than 0 in the 16-bit SIMD decoders */
+#define SMETRIC_UNREACHED (-16384)
+
+static void init_mettab(void)
 {
     int i;
 
@@ -126,51 +135,77 @@ void vitfilt27_init(v27 *vi)
         mettab[0][i] = 128 - i;
         mettab[1][255-i] = 127 - i;
     }
+}
+
+void vitfilt27_init(v27 *vi)
+{
+    int i;
+
+    init_mettab();
 
     vi->cmetric[0] = 0;
     for(i=1; i<64; i++)
         vi->cmetric[i] = -99999;
 
+    vi->smetric[0] = 0;
+    for(i=1; i<64; i++)
+        vi->smetric[i] = SMETRIC_UNREACHED;
+
     vi->pi = 0;
+    vi->tbvalid = 0;
 }
 
-/* Periodic traceback to produce decoded data */
+/* Periodic traceback to produce decoded data
+ *
+ * Each traceback starts TRACECHUNK bits after the previous one, and the
+ * two paths almost always merge a few bits before the previous starting
+ * point. The states of the last traced path are kept in vi->tbpath[], so
+ * the chain is only followed until it meets that path; from there on the
+ * old states are the new ones, and the decoded bits are read from them.
+ * The result is that of tracing the whole MERGEDIST every time.
+ */
 static void
-traceback(unsigned long paths[],unsigned int pi, unsigned char *dst)
+traceback(v27 *vi, unsigned char *dst)
 {
+    /* path states traced: MERGEDIST-6 before the data, the data bits, and
+     * the state after the last of them, which holds its bit
+     */
+    const int nstates = MERGEDIST-6 + TRACECHUNK + 1;
     int beststate,i,j;
+    unsigned int bit,pi;
     unsigned char data[TRACECHUNK/8];
 
     /* Start on an arbitrary path and trace it back until it's almost
      * certain we've merged onto the best path
      */
     beststate = 0;	/* arbitrary */
-    pi = (pi - 1) % PATHMEM;	/* Undo last increment of pi */
-    for(i=0; i < MERGEDIST-6; i++)
+    pi = (vi->pi - 1) % PATHMEM;	/* Undo last increment of pi */
+    /* The decision bits are random, so the chain is followed without
+     * branches: a mispredicted branch per step would cost more than the
+     * rest of the traceback.
+     */
+    for(i=0; i < nstates; i++)
     {
-        if(paths[2*pi + (beststate >> 5)] & (1 << (beststate & 31)))
-        {
-            beststate |= 64;	/* 2^(K-1) */
-        }
-        beststate >>= 1;
+        if(i >= TRACECHUNK && vi->tbvalid && vi->tbpath[pi] == beststate)
+            break;	/* merged onto the previous path */
+        vi->tbpath[pi] = beststate;
+        bit = (vi->paths[2*pi + (beststate >> 5)] >> (beststate & 31)) & 1;
+        beststate = (beststate >> 1) | (bit << 5);	/* 2^(K-1) >> 1 */
         pi = (pi - 1) % PATHMEM;
     }
-    /* bestpath is now the encoder state on the best path, MERGEDIST
-     * bits back. We continue to chain back until we accumulate
-     * TRACECHUNK bits of decoded data
+    vi->tbvalid = 1;
+
+    /* The state MERGEDIST bits back is on the best path. Each bit of
+     * decoded data is the top bit of the state before it.
      */
+    pi = (vi->pi - 1 - (MERGEDIST-6)) % PATHMEM;
     for(j=sizeof(data)-1; j >= 0; j--)
     {
         data[j] = 0;
         for(i=0; i<8; i++)
         {
-            if(paths[2*pi + (beststate >> 5)] & (1 << (beststate & 31)))
-            {
-                beststate |= 64;	/* 2^(K-1) */
-                data[j] |= 1 << i;
-            }
-            beststate >>= 1;
             pi = (pi - 1) % PATHMEM;
+            data[j] |= (vi->tbpath[pi] >> 5) << i;
         }
     }
 
@@ -181,7 +216,7 @@ traceback(unsigned long paths[],unsigned int pi, unsigned char *dst)
     } 
 }
 
-void vitfilt27_decode(v27 *vi, unsigned char *syms, unsigned char *data, unsigned int nbits)
+void vitfilt27_decode_generic(v27 *vi, unsigned char *syms, unsigned char *data, unsigned int nbits)
 {
     int i;
     unsigned char symbols[2];
@@ -315,7 +350,7 @@ void vitfilt27_decode(v27 *vi, unsigned char *syms, unsigned char *data, unsigne
         vi->pi = (vi->pi + 1) % PATHMEM;
         if((vi->pi % TRACECHUNK) == 0)
         {
-            traceback(vi->paths, vi->pi, data);
+            traceback(vi, data);
 
             //printf("data: %d", data);
             data += TRACECHUNK/8;
@@ -323,6 +358,344 @@ void vitfilt27_decode(v27 *vi, unsigned char *syms, unsigned char *data, unsigne
     }
 }
 
+/* Add-compare-select over nsteps bits with 16-bit path metrics, for the
+ * chunked decoder below and the block decoder. The decisions of bit t go
+ * to paths[2*t] (states 0-31) and paths[2*t+1] (states 32-63), the layout
+ * of the scalar decoder, so the traceback is shared.
+ *
+ * The branch metrics follow the symbol pairs of the BUTTERFLY() calls:
+ * butterflies 0-15 expect 1,3,2,0,2,0,1,3 (twice) and 16-31 the same with
+ * the second symbol inverted.
+ *
+ * Only the differences between the metrics matter, so after every
+ * TRACECHUNK bits, and at the end of each call, the metric of state 0 is
+ * subtracted from all of them; in between they stay within the metric
+ * spread plus TRACECHUNK branches, far from the limits of 16 bits. The
+ * decisions, ties included, are those of the scalar decoder.
+ */
+typedef void (*acs_fn)(short *smetric, const unsigned char *syms, unsigned long *paths, unsigned int nsteps);
+
+static const unsigned char Branchsym[32] =
+{
+    1, 3, 2, 0, 2, 0, 1, 3, 1, 3, 2, 0, 2, 0, 1, 3,
+    0, 2, 3, 1, 3, 1, 0, 2, 0, 2, 3, 1, 3, 1, 0, 2,
+};
+
+static void acs_generic(short *smetric, const unsigned char *syms, unsigned long *paths, unsigned int nsteps)
+{
+    int m[64], n[64], mets[4], i;
+    unsigned int t;
+    unsigned long long dec;
+
+    for(i=0; i<64; i++)
+        m[i] = smetric[i];
+
+    for(t=0; t<nsteps; t++)
+    {
+        mets[0] = mettab[0][syms[0]] + mettab[0][syms[1]];
+        mets[1] = mettab[0][syms[0]] + mettab[1][syms[1]];
+        mets[3] = mettab[1][syms[0]] + mettab[1][syms[1]];
+        mets[2] = mettab[1][syms[0]] + mettab[0][syms[1]];
+        syms += 2;
+
+        dec = 0;
+        for(i=0; i<32; i++)
+        {
+            const int sym = Branchsym[i];
+            int m0 = m[i] + mets[sym];
+            int m1 = m[i+32] + mets[3^sym];
+            n[2*i] = m1 > m0 ? m1 : m0;
+            dec |= (unsigned long long)(m1 > m0) << (2*i);
+            m0 = m[i] + mets[3^sym];
+            m1 = m[i+32] + mets[sym];
+            n[2*i+1] = m1 > m0 ? m1 : m0;
+            dec |= (unsigned long long)(m1 > m0) << (2*i+1);
+        }
+        paths[2*t] = dec & 0xffffffff;
+        paths[2*t+1] = dec >> 32;
+
+        if((t % TRACECHUNK) == TRACECHUNK-1 || t == nsteps-1)
+        {
+            for(i=0; i<64; i++)
+                m[i] = n[i] - n[0];
+        }
+        else
+        {
+            for(i=0; i<64; i++)
+                m[i] = n[i];
+        }
+    }
+
+    for(i=0; i<64; i++)
+        smetric[i] = m[i];
+}
+
+#ifdef VITERBI27_X86
+/* SIMD versions: the metrics stay in vector registers for the whole call,
+ * the 64 states in 4 AVX2 or 8 SSE2 registers, with saturating adds.
+ * Butterfly i (old states i and i+32, new states 2i and 2i+1) is lane i,
+ * so one vector ACS does 16 (AVX2) or 8 (SSE2) butterflies. The new
+ * metrics are interleaved back into state order with unpacks, and the
+ * decisions packed to bytes and collected with movemask. Each lane selects
+ * the metric of its first and of its second symbol with a mask and adds
+ * them.
+ */
+
+/* first and second symbol of the pairs of butterflies 0-7, -1 for a 1 */
+#define B0_MASK 0, -1, -1, 0, -1, 0, 0, -1
+#define B1_MASK -1, -1, 0, 0, 0, 0, -1, -1
+
+__attribute__((target("avx2"), always_inline))
+static inline unsigned int butterflies_avx2(__m256i lo, __m256i hi, __m256i a, __m256i b, __m256i *n0, __m256i *n1)
+{
+    const __m256i m00 = _mm256_adds_epi16(lo, a);	/* 2*i from i */
+    const __m256i m01 = _mm256_adds_epi16(hi, b);	/* 2*i from i + 32 */
+    const __m256i m10 = _mm256_adds_epi16(lo, b);	/* 2*i + 1 from i */
+    const __m256i m11 = _mm256_adds_epi16(hi, a);	/* 2*i + 1 from i + 32 */
+    const __m256i d0 = _mm256_max_epi16(m00, m01);
+    const __m256i d1 = _mm256_max_epi16(m10, m11);
+    const __m256i c0 = _mm256_cmpgt_epi16(m01, m00);
+    const __m256i c1 = _mm256_cmpgt_epi16(m11, m10);
+
+    /* the unpacks work per 128-bit lane: states 0-7|16-23 and 8-15|24-31 */
+    const __m256i u0 = _mm256_unpacklo_epi16(d0, d1);
+    const __m256i u1 = _mm256_unpackhi_epi16(d0, d1);
+    *n0 = _mm256_permute2x128_si256(u0, u1, 0x20);
+    *n1 = _mm256_permute2x128_si256(u0, u1, 0x31);
+    /* which packs puts back in order */
+    return _mm256_movemask_epi8(_mm256_packs_epi16(_mm256_unpacklo_epi16(c0, c1), _mm256_unpackhi_epi16(c0, c1)));
+}
+
+__attribute__((target("avx2")))
+static void acs_avx2(short *smetric, const unsigned char *syms, unsigned long *paths, unsigned int nsteps)
+{
+    const __m256i b0 = _mm256_setr_epi16(B0_MASK, B0_MASK);
+    const __m256i b1 = _mm256_setr_epi16(B1_MASK, B1_MASK);
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)&smetric[0]);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)&smetric[16]);
+    __m256i v2 = _mm256_loadu_si256((const __m256i *)&smetric[32]);
+    __m256i v3 = _mm256_loadu_si256((const __m256i *)&smetric[48]);
+    unsigned int t;
+
+    for(t=0; t<nsteps; t++)
+    {
+        const int x0 = mettab[0][syms[0]], x1 = mettab[1][syms[0]];
+        const int y0 = mettab[0][syms[1]], y1 = mettab[1][syms[1]];
+        syms += 2;
+
+        /* xa, ya: metrics of the expected symbols, xb, yb: of the others */
+        const __m256i dx = _mm256_set1_epi16(x0 ^ x1);
+        const __m256i dy = _mm256_set1_epi16(y0 ^ y1);
+        const __m256i xa = _mm256_xor_si256(_mm256_set1_epi16(x0), _mm256_and_si256(dx, b0));
+        const __m256i ya = _mm256_xor_si256(_mm256_set1_epi16(y0), _mm256_and_si256(dy, b1));
+        const __m256i xb = _mm256_xor_si256(xa, dx);
+        const __m256i yb = _mm256_xor_si256(ya, dy);
+
+        __m256i n0, n1, n2, n3;
+        paths[2*t] = butterflies_avx2(v0, v2, _mm256_add_epi16(xa, ya), _mm256_add_epi16(xb, yb), &n0, &n1);
+        paths[2*t+1] = butterflies_avx2(v1, v3, _mm256_add_epi16(xa, yb), _mm256_add_epi16(xb, ya), &n2, &n3);
+        v0 = n0;
+        v1 = n1;
+        v2 = n2;
+        v3 = n3;
+
+        if((t % TRACECHUNK) == TRACECHUNK-1 || t == nsteps-1)
+        {
+            const __m256i bias = _mm256_broadcastw_epi16(_mm256_castsi256_si128(v0));
+            v0 = _mm256_subs_epi16(v0, bias);
+            v1 = _mm256_subs_epi16(v1, bias);
+            v2 = _mm256_subs_epi16(v2, bias);
+            v3 = _mm256_subs_epi16(v3, bias);
+        }
+    }
+
+    _mm256_storeu_si256((__m256i *)&smetric[0], v0);
+    _mm256_storeu_si256((__m256i *)&smetric[16], v1);
+    _mm256_storeu_si256((__m256i *)&smetric[32], v2);
+    _mm256_storeu_si256((__m256i *)&smetric[48], v3);
+}
+
+__attribute__((target("sse2"), always_inline))
+static inline unsigned int butterflies_sse2(__m128i lo, __m128i hi, __m128i a, __m128i b, __m128i *n0, __m128i *n1)
+{
+    const __m128i m00 = _mm_adds_epi16(lo, a);
+    const __m128i m01 = _mm_adds_epi16(hi, b);
+    const __m128i m10 = _mm_adds_epi16(lo, b);
+    const __m128i m11 = _mm_adds_epi16(hi, a);
+    const __m128i d0 = _mm_max_epi16(m00, m01);
+    const __m128i d1 = _mm_max_epi16(m10, m11);
+    const __m128i c0 = _mm_cmpgt_epi16(m01, m00);
+    const __m128i c1 = _mm_cmpgt_epi16(m11, m10);
+
+    *n0 = _mm_unpacklo_epi16(d0, d1);
+    *n1 = _mm_unpackhi_epi16(d0, d1);
+    return _mm_movemask_epi8(_mm_packs_epi16(_mm_unpacklo_epi16(c0, c1), _mm_unpackhi_epi16(c0, c1)));
+}
+
+__attribute__((target("sse2")))
+static void acs_sse2(short *smetric, const unsigned char *syms, unsigned long *paths, unsigned int nsteps)
+{
+    const __m128i b0 = _mm_setr_epi16(B0_MASK);
+    const __m128i b1 = _mm_setr_epi16(B1_MASK);
+    __m128i v[8], n[8];
+    unsigned int t;
+    int i;
+
+    for(i=0; i<8; i++)
+        v[i] = _mm_loadu_si128((const __m128i *)&smetric[8*i]);
+
+    for(t=0; t<nsteps; t++)
+    {
+        const int x0 = mettab[0][syms[0]], x1 = mettab[1][syms[0]];
+        const int y0 = mettab[0][syms[1]], y1 = mettab[1][syms[1]];
+        syms += 2;
+
+        const __m128i dx = _mm_set1_epi16(x0 ^ x1);
+        const __m128i dy = _mm_set1_epi16(y0 ^ y1);
+        const __m128i xa = _mm_xor_si128(_mm_set1_epi16(x0), _mm_and_si128(dx, b0));
+        const __m128i ya = _mm_xor_si128(_mm_set1_epi16(y0), _mm_and_si128(dy, b1));
+        const __m128i xb = _mm_xor_si128(xa, dx);
+        const __m128i yb = _mm_xor_si128(ya, dy);
+        const __m128i a01 = _mm_add_epi16(xa, ya), b01 = _mm_add_epi16(xb, yb);
+        const __m128i a23 = _mm_add_epi16(xa, yb), b23 = _mm_add_epi16(xb, ya);
+
+        paths[2*t] = butterflies_sse2(v[0], v[4], a01, b01, &n[0], &n[1]) |
+                     butterflies_sse2(v[1], v[5], a01, b01, &n[2], &n[3]) << 16;
+        paths[2*t+1] = butterflies_sse2(v[2], v[6], a23, b23, &n[4], &n[5]) |
+                       butterflies_sse2(v[3], v[7], a23, b23, &n[6], &n[7]) << 16;
+        for(i=0; i<8; i++)
+            v[i] = n[i];
+
+        if((t % TRACECHUNK) == TRACECHUNK-1 || t == nsteps-1)
+        {
+            const __m128i bias = _mm_shuffle_epi32(_mm_shufflelo_epi16(v[0], 0), 0);
+            for(i=0; i<8; i++)
+                v[i] = _mm_subs_epi16(v[i], bias);
+        }
+    }
+
+    for(i=0; i<8; i++)
+        _mm_storeu_si128((__m128i *)&smetric[8*i], v[i]);
+}
+#endif
+
+struct vitfilt27_kernel_t
+{
+    const char *name;
+    acs_fn acs;
+};
+
+static const struct vitfilt27_kernel_t *select_kernel(void)
+{
+    static const struct vitfilt27_kernel_t generic = {"generic", acs_generic};
+#ifdef VITERBI27_X86
+    static const struct vitfilt27_kernel_t avx2 = {"avx2", acs_avx2};
+    static const struct vitfilt27_kernel_t sse2 = {"sse2", acs_sse2};
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return &avx2;
+    if(__builtin_cpu_supports("sse2"))
+        return &sse2;
+#endif
+    return &generic;
+}
+
+static const struct vitfilt27_kernel_t *kernel(void)
+{
+    static const struct vitfilt27_kernel_t *k;
+    const struct vitfilt27_kernel_t *p = __atomic_load_n(&k, __ATOMIC_ACQUIRE);
+    if(!p)
+    {
+        p = select_kernel();
+        __atomic_store_n(&k, p, __ATOMIC_RELEASE);
+    }
+    return p;
+}
+
+/* The ACS runs up to the next traceback, in place in the path memory */
+void vitfilt27_decode(v27 *vi, unsigned char *syms, unsigned char *data, unsigned int nbits)
+{
+    const acs_fn acs = kernel()->acs;
+    unsigned int n;
+
+    while(nbits >= 2)
+    {
+        n = TRACECHUNK - vi->pi % TRACECHUNK;
+        if(2*n > nbits)
+            n = nbits/2;
+        acs(vi->smetric, syms, &vi->paths[2*vi->pi], n);
+        syms += 2*n;
+        nbits -= 2*n;
+        vi->pi = (vi->pi + n) % PATHMEM;
+        if((vi->pi % TRACECHUNK) == 0)
+        {
+            traceback(vi, data);
+            data += TRACECHUNK/8;
+        }
+    }
+}
+
+const char *vitfilt27_kernel(void)
+{
+    return kernel()->name;
+}
+
+int vitfilt27_block_init(v27_block *vb, unsigned int maxbits)
+{
+    init_mettab();
+    vb->paths = malloc(2 * (size_t)maxbits * sizeof(unsigned long));
+    vb->maxbits = vb->paths ? maxbits : 0;
+    return vb->paths ? 0 : -1;
+}
+
+void vitfilt27_block_free(v27_block *vb)
+{
+    free(vb->paths);
+    vb->paths = NULL;
+    vb->maxbits = 0;
+}
+
+/* The encoder starts every block in state 0. With the decisions of the
+ * whole block in memory a single traceback from the last state gives the
+ * maximum likelihood path, and as the newest bit of a state is its low bit,
+ * each state on the path is one decoded bit.
+ */
+int vitfilt27_decode_block(v27_block *vb, const unsigned char *syms, unsigned char *data, unsigned int nbits,
+                           int endstate)
+{
+    const unsigned long *paths = vb->paths;
+    unsigned int bit,t;
+    int state,i;
+
+    if(nbits > vb->maxbits)
+        return -1;
+
+    vb->smetric[0] = 0;
+    for(i=1; i<64; i++)
+        vb->smetric[i] = SMETRIC_UNREACHED;
+    kernel()->acs(vb->smetric, syms, vb->paths, nbits);
+
+    state = endstate;
+    if(state < 0)
+    {
+        /* not terminated: the best path ends in the best state */
+        state = 0;
+        for(i=1; i<64; i++)
+            if(vb->smetric[i] > vb->smetric[state])
+                state = i;
+    }
+
+    for(t=0; t<(nbits+7)/8; t++)
+        data[t] = 0;
+    for(t=nbits; t-- > 0; )
+    {
+        data[t/8] |= (state & 1) << (7 - t%8);
+        bit = (paths[2*t + (state >> 5)] >> (state & 31)) & 1;
+        state = (state >> 1) | (bit << 5);
+    }
+    return 0;
+}
+
 
 extern unsigned char Partab[];	/* Parity lookup table */
 
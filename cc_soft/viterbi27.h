@@ -113,12 +113,23 @@ typedef struct v27
 {
     long cmetric[64];
     long nmetric[64];
+    short smetric[64];	/* path metrics of the SIMD decoders */
     unsigned long paths[2*PATHMEM];
     unsigned int pi;
+    unsigned char tbpath[PATHMEM];	/* states of the last traceback */
+    int tbvalid;
     unsigned long dec;
     int mets[4];
 } v27;
 
+/* Block decoder state: the decisions of a whole block */
+typedef struct v27_block
+{
+    unsigned long *paths;	/* 2 words per bit, as in v27 */
+    unsigned int maxbits;
+    short smetric[64];
+} v27_block;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -131,7 +142,38 @@ unsigned int encode27(unsigned char *encstate,
     const int* puncture_C2_ptr,
     int puncture_pattern_len);
 void vitfilt27_init(v27 *vi);
+/* Decodes nbits symbols (a multiple of 2*TRACECHUNK) of a continuous
+ * stream with the fastest ACS the CPU supports: AVX2 or SSE2 with 16-bit
+ * path metrics, or portable C. The output lags the input by MERGEDIST
+ * bits. Punctured codes are decoded by sending erasures (128) in place of
+ * the deleted symbols.
+ */
 void vitfilt27_decode(v27 *vi, unsigned char *syms, unsigned char *data, unsigned int nbits);
+/* The original scalar decoder, with long path metrics. It gives the same
+ * output but keeps its own metrics, so a v27 must stay with one of the two.
+ */
+void vitfilt27_decode_generic(v27 *vi, unsigned char *syms, unsigned char *data, unsigned int nbits);
+/* Name of the decoder vitfilt27_decode() runs: "avx2", "sse2" or "generic" */
+const char *vitfilt27_kernel(void);
+
+/* Block decoding of frames the encoder starts in state 0 (encstate = 0
+ * before each frame): the decisions of the whole frame are kept and traced
+ * back once from its last state, so there is no decoding delay, no warm-up
+ * and no padding. The ACS is that of vitfilt27_decode().
+ *
+ * vitfilt27_block_init() allocates the decisions of up to maxbits bits,
+ * 16 bytes per bit, and returns -1 if it can't.
+ */
+int vitfilt27_block_init(v27_block *vb, unsigned int maxbits);
+void vitfilt27_block_free(v27_block *vb);
+/* Decodes the 2*nbits symbols of nbits data bits into (nbits+7)/8 bytes,
+ * first bit in the high order bit. endstate is the encoder state after
+ * the last bit, e.g. 0 after 6 or more zero tail bits, or -1 if the block
+ * isn't terminated (the path ending in the best state is taken).
+ * Returns -1 if nbits is over maxbits.
+ */
+int vitfilt27_decode_block(v27_block *vb, const unsigned char *syms, unsigned char *data, unsigned int nbits,
+                           int endstate);
 void encode27_bit(unsigned char *encstate, unsigned char *symbols, unsigned char *data);
 
 #ifdef __cplusplus
@@ -4,22 +4,23 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include "randomizer.h"
 
-// reed solomon(233,255) constants
+// reed solomon(255,223) constants, the default code; the field and
+// generator parameters of all supported codes are in rs_codec.h
 #define RS_BITS_PER_SYM 8
 #define RS_DATA_LEN 223
 #define RS_PARITY_LEN 32
 #define RS_BLOCK_LEN (RS_DATA_LEN + RS_PARITY_LEN)
 #define RS_MAX_NBLOCKS 8
-#define RS_GFPOLY 0x187 // (x^8 + x^7 + x^2 + x^1 + 1)
-#define RS_APRIM 11
-#define RS_FCS 112
+// largest data length of the supported codes, RS(255,239)
+#define RS_MAX_DATA_LEN 239
 
 // frame constants
 #define SYNC_WORD_LEN 4
 //#define SYNC_WORD 0x1acffc1d
 #define SCRAMBLER_POLY_LEN 255
-#define DATA_MAX_LEN (RS_DATA_LEN * RS_MAX_NBLOCKS)
+#define DATA_MAX_LEN (RS_MAX_DATA_LEN * RS_MAX_NBLOCKS)
 #define CODEWORD_MAX_LEN (RS_BLOCK_LEN * RS_MAX_NBLOCKS)
 //#define TOTAL_FRAME_LEN (SYNC_WORD_LEN + CODEWORD_LEN)
 
@@ -30,7 +31,7 @@ struct ccsds_tx_pkt {
 
 const uint8_t SYNC_WORD[SYNC_WORD_LEN] = {0x1a, 0xcf, 0xfc, 0x1d};
 // generator polynome: 0x1a9 (x^8 + x^7 + x^5 + x^3 + 1)
-const uint8_t SCRAMBLER_POLY[SCRAMBLER_POLY_LEN] = {0xFF, 0x48, 0x0E, 0xC0, 0x9A, 0x0D, 0x70, 0xBC,
+constexpr uint8_t SCRAMBLER_POLY[SCRAMBLER_POLY_LEN] = {0xFF, 0x48, 0x0E, 0xC0, 0x9A, 0x0D, 0x70, 0xBC,
             0x8E, 0x2C, 0x93, 0xAD, 0xA7, 0xB7, 0x46, 0xCE, 0x5A, 0x97, 0x7D, 0xCC, 0x32,
             0xA2, 0xBF, 0x3E, 0x0A, 0x10, 0xF1, 0x88, 0x94, 0xCD, 0xEA, 0xB1, 0xFE, 0x90,
             0x1D, 0x81, 0x34, 0x1A, 0xE1, 0x79, 0x1C, 0x59, 0x27, 0x5B, 0x4F, 0x6E, 0x8D,
@@ -88,10 +89,7 @@ inline void print_bytes(uint8_t *data, uint32_t length)
 
 inline void scramble(uint8_t *data, uint32_t length)
 {
-    for (uint32_t i=0; i<length; i++)
-    {
-        data[i] ^= SCRAMBLER_POLY[i%SCRAMBLER_POLY_LEN];
-    }
+    randomize(data, length, 0, data);
 }
 inline void descramble(uint8_t *data, uint32_t length)
 {
@@ -99,4 +97,14 @@ inline void descramble(uint8_t *data, uint32_t length)
     scramble(data, length);
 }
 
+// same as above, for data at byte offset of a randomized codeword
+inline void scramble(uint8_t *data, uint32_t length, uint32_t offset)
+{
+    randomize(data, length, offset, data);
+}
+inline void descramble(uint8_t *data, uint32_t length, uint32_t offset)
+{
+    scramble(data, length, offset);
+}
+
 #endif // __CCSDS_H__
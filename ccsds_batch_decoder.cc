@@ -0,0 +1,235 @@
+// Batched, multi-threaded CCSDS Reed-Solomon decoder
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "reed_solomon.h"
+#include "crc16.h"
+#include "ccsds.h"
+#include "ccsds_batch_decoder.h"
+
+ccsds_batch_decoder::ccsds_batch_decoder(bool rs_decode,
+                                         bool deinterleave,
+                                         bool descramble,
+                                         int n_interleave,
+                                         bool dual_basis,
+                                         rs_code_t rs_code,
+                                         int virtual_fill,
+                                         int n_threads,
+                                         const randomizer* scrambler)
+    : ccsds_batch_decoder(rs_decode, deinterleave, descramble, n_interleave, dual_basis, rs_code, virtual_fill,
+                          new rs_thread_pool(n_threads), scrambler)
+{
+    d_own_pool.reset(d_pool);
+}
+
+ccsds_batch_decoder::ccsds_batch_decoder(bool rs_decode,
+                                         bool deinterleave,
+                                         bool descramble,
+                                         int n_interleave,
+                                         bool dual_basis,
+                                         rs_code_t rs_code,
+                                         int virtual_fill,
+                                         rs_thread_pool* pool,
+                                         const randomizer* scrambler)
+    : d_rs_decode(rs_decode), d_deinterleave(deinterleave), d_descramble(descramble),
+      d_n_interleave(n_interleave), d_dual_basis(dual_basis), d_rs(rs_code, virtual_fill),
+      d_scrambler(scrambler ? scrambler : &randomizer::get(RANDOMIZER_CCSDS)), d_pool(pool)
+{
+    if (d_rs_decode && d_descramble)
+    {
+        // the randomizer is added modulo 2 to every codeword symbol and the
+        // syndromes are linear, so its contribution is a per-block constant
+        std::vector<uint8_t> sequence(codeword_len(), 0);
+        d_scrambler->apply(sequence.data(), codeword_len());
+        frame_syndromes(sequence.data(), d_scrambler_syn);
+    }
+}
+
+int ccsds_batch_decoder::decode(const uint8_t* frames, const uint8_t* reliability, int n_frames,
+                                uint8_t* payloads, ccsds_frame_status* status)
+{
+    if (n_frames <= 0) return 0;
+
+    if (n_frames > d_jobs_len)
+    {
+        d_jobs.reset(new frame_job[n_frames]);
+        d_jobs_len = n_frames;
+        d_codewords.resize((size_t)n_frames * codeword_len());
+    }
+
+    for (int f = 0; f < n_frames; f++)
+    {
+        frame_job& job = d_jobs[f];
+        job.codeword = &d_codewords[(size_t)f * codeword_len()];
+        job.reliability = reliability ? &reliability[(size_t)f * frame_len() + SYNC_WORD_LEN] : nullptr;
+        job.payload = &payloads[(size_t)f * data_len()];
+        job.n_corrected = 0;
+        job.failed_blocks = 0;
+
+        // skip the sync sequence, the frames are aligned
+        const uint8_t* in = &frames[(size_t)f * frame_len() + SYNC_WORD_LEN];
+        d_pool->submit([this, &job, in]() {
+            memcpy(job.codeword, in, codeword_len());
+            decode_frame(job);
+        });
+    }
+    d_pool->wait();
+
+    int n_decoded = 0;
+    for (int f = 0; f < n_frames; f++)
+    {
+        const frame_job& job = d_jobs[f];
+        ccsds_frame_status& st = status[f];
+        st.failed_blocks = job.failed_blocks;
+        st.n_corrected = job.n_corrected;
+        st.fecf_failed = d_fecf && st.failed_blocks == 0 && !fecf_check(job.payload, data_len());
+        st.decoded = st.failed_blocks == 0 && !st.fecf_failed;
+        st.fast_path = st.decoded && st.n_corrected == 0;
+        if (st.decoded) n_decoded++;
+        if (st.fecf_failed) d_num_frames_fecf_failed++;
+        if (st.fast_path) d_num_frames_fast_path++;
+    }
+    d_num_frames_received += n_frames;
+    d_num_frames_decoded += n_decoded;
+    return n_decoded;
+}
+
+uint32_t ccsds_batch_decoder::frame_syndromes(const uint8_t* codeword, uint8_t (*syn)[RS_PARITY_LEN])
+{
+    if (d_deinterleave)
+    {
+        return d_rs.syndromes(codeword, d_n_interleave, syn, d_dual_basis);
+    }
+
+    uint32_t dirty = 0;
+    for (int i = 0; i < d_n_interleave; i++)
+    {
+        dirty |= d_rs.syndromes(&codeword[i * d_rs.block_len()], 1, &syn[i], d_dual_basis) << i;
+    }
+    return dirty;
+}
+
+void ccsds_batch_decoder::decode_frame(frame_job& job)
+{
+    // syndromes of all blocks in one pass over the (still randomized) codeword
+    uint32_t dirty = 0;
+    if (d_rs_decode)
+    {
+        frame_syndromes(job.codeword, job.syn);
+        for (int i = 0; i < d_n_interleave; i++)
+        {
+            uint8_t any = 0;
+            for (int j = 0; j < d_rs.parity_len(); j++)
+            {
+                if (d_descramble) job.syn[i][j] ^= d_scrambler_syn[i][j];
+                any |= job.syn[i][j];
+            }
+            if (any) dirty |= 1u << i;
+        }
+#ifdef RS_STATS
+        collect_stats(~dirty & ((1u << d_n_interleave) - 1), 0);
+#endif
+    }
+
+    if (d_descramble)
+    {
+        d_scrambler->apply(job.codeword, codeword_len());
+    }
+
+    if (!dirty && d_deinterleave)
+    {
+        // the interleaved data rows are a prefix of the codeword
+        memcpy(job.payload, job.codeword, data_len());
+        return;
+    }
+
+    for (int i = 0; i < d_n_interleave; i++)
+    {
+        if (dirty & (1u << i))
+        {
+            d_pool->submit([this, &job, i]() { decode_block(job, i); });
+        }
+        else
+        {
+            extract_block(job.codeword, job.payload, i);
+        }
+    }
+}
+
+void ccsds_batch_decoder::decode_block(frame_job& job, int block)
+{
+    const int n = d_rs.block_len();
+    uint8_t rs_block[RS_BLOCK_LEN];
+    uint8_t rs_reliability[RS_BLOCK_LEN];
+    for (int j = 0; j < n; j++)
+    {
+        rs_block[j] = d_deinterleave ? job.codeword[block + j * d_n_interleave] : job.codeword[block * n + j];
+    }
+
+    int16_t nerrors;
+    if (job.reliability)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            rs_reliability[j] = d_deinterleave ? job.reliability[block + j * d_n_interleave]
+                                               : job.reliability[block * n + j];
+        }
+        nerrors = d_rs.decode_with_syndromes(rs_block, job.syn[block], rs_reliability, d_dual_basis);
+    }
+    else
+    {
+        nerrors = d_rs.decode_with_syndromes(rs_block, job.syn[block], d_dual_basis);
+    }
+
+    if (nerrors < 0)
+    {
+        job.failed_blocks.fetch_or(1u << block);
+    }
+    else
+    {
+        job.n_corrected.fetch_add(nerrors);
+    }
+#ifdef RS_STATS
+    collect_stats(1u << block, nerrors);
+#endif
+
+    // rs_block is gathered, so it is scattered with the single block layout
+    const int k = d_rs.data_len();
+    for (int j = 0; j < k; j++)
+    {
+        if (d_deinterleave)
+            job.payload[block + j * d_n_interleave] = rs_block[j];
+        else
+            job.payload[block * k + j] = rs_block[j];
+    }
+}
+
+void ccsds_batch_decoder::extract_block(const uint8_t* codeword, uint8_t* payload, int block) const
+{
+    const int k = d_rs.data_len();
+    if (d_deinterleave)
+    {
+        for (int j = 0; j < k; j++)
+        {
+            payload[block + j * d_n_interleave] = codeword[block + j * d_n_interleave];
+        }
+    }
+    else
+    {
+        memcpy(&payload[block * k], &codeword[block * d_rs.block_len()], k);
+    }
+}
+
+#ifdef RS_STATS
+// records the given lanes and the stage timings of the calling worker
+void ccsds_batch_decoder::collect_stats(uint32_t lanes, int nerrors)
+{
+    std::lock_guard<std::mutex> lock(d_stats_mutex);
+    for (int i = 0; i < d_n_interleave; i++)
+    {
+        if (lanes & (1u << i)) d_stats.record(i, nerrors);
+    }
+    rs_stats_collect(d_stats);
+}
+#endif
@@ -0,0 +1,169 @@
+#ifndef CCSDS_BATCH_DECODER_H
+#define CCSDS_BATCH_DECODER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "reed_solomon.h"
+#include "rs_thread_pool.h"
+#include "rs_stats.h"
+#include "randomizer.h"
+#include "ccsds.h"
+
+/**
+ * Per-frame result of ccsds_batch_decoder::decode().
+ */
+struct ccsds_frame_status
+{
+    bool decoded;           // every RS block is a valid codeword after decoding
+                            // (and the FECF matches, if checked)
+    bool fast_path;         // no RS block needed correction
+    int16_t n_corrected;    // corrected symbols over all RS blocks
+    uint32_t failed_blocks; // bit i set if RS block i could not be corrected
+    bool fecf_failed;       // the FECF is checked and doesn't match
+};
+
+/**
+ * Decodes batches of aligned CCSDS frames on a work-stealing thread pool.
+ *
+ * Every frame becomes one task: it computes the syndromes of all its RS
+ * blocks in one pass and, if they are clean, extracts the payload right
+ * away. Each RS block that needs correcting is spawned as a task of its own,
+ * so idle workers pick up the expensive codewords of noisy frames while the
+ * clean frames of the batch complete. Payloads are written in frame order.
+ */
+class ccsds_batch_decoder {
+public:
+    /**
+     * @param n_threads Worker threads, 0 for one per hardware thread
+     * @param scrambler Randomizer removed if descramble is set, nullptr for
+     *                  the CCSDS one; must outlive the decoder
+     */
+    ccsds_batch_decoder(bool rs_decode,
+                        bool deinterleave,
+                        bool descramble,
+                        int n_interleave,
+                        bool dual_basis,
+                        rs_code_t rs_code = RS_CODE_255_223,
+                        int virtual_fill = 0,
+                        int n_threads = 0,
+                        const randomizer* scrambler = nullptr);
+
+    /**
+     * Same as above, the tasks run on pool, which may be shared with other
+     * decoders (one decode() call at a time) and must outlive this one.
+     */
+    ccsds_batch_decoder(bool rs_decode,
+                        bool deinterleave,
+                        bool descramble,
+                        int n_interleave,
+                        bool dual_basis,
+                        rs_code_t rs_code,
+                        int virtual_fill,
+                        rs_thread_pool* pool,
+                        const randomizer* scrambler = nullptr);
+    ~ccsds_batch_decoder() = default;
+
+    /**
+     * Decodes n_frames frames of frame_len() bytes each (ASM followed by the
+     * codeword, as for ccsds_rs_decoder::decode_aligned_bytes()).
+     *
+     * @param frames      n_frames * frame_len() input bytes
+     * @param reliability Optional, one value per input byte for errors-and-erasures
+     *                    decoding (see ccsds_rs_decoder), or nullptr
+     * @param n_frames    Number of frames
+     * @param payloads    Output, n_frames * data_len() bytes. The payload of
+     *                    an undecodable frame holds the uncorrected data.
+     * @param status      Output, one entry per frame
+     * @return            Number of frames decoded
+     */
+    int decode(const uint8_t* frames, const uint8_t* reliability, int n_frames,
+               uint8_t* payloads, ccsds_frame_status* status);
+
+    /**
+     * Upper bound on the erasures per RS block, see reed_solomon::set_max_erasures().
+     */
+    void set_max_erasures(int max_erasures) { d_rs.set_max_erasures(max_erasures); }
+
+    /**
+     * Checks the FECF of every decoded payload, see ccsds_rs_decoder::set_fecf().
+     */
+    void set_fecf(bool fecf) { d_fecf = fecf; }
+
+    inline int data_len() const { return d_rs.data_len() * d_n_interleave; }
+    inline int codeword_len() const { return d_rs.block_len() * d_n_interleave; }
+    inline int frame_len() const { return SYNC_WORD_LEN + codeword_len(); }
+
+    int num_threads() const { return d_pool->size(); }
+
+    uint32_t num_frames_received() const { return d_num_frames_received; }
+    uint32_t num_frames_decoded()  const { return d_num_frames_decoded; }
+    uint32_t num_frames_fast_path() const { return d_num_frames_fast_path; }
+    uint32_t num_frames_fecf_failed() const { return d_num_frames_fecf_failed; }
+
+    /**
+     * @return Per-stage timings (summed over the workers) and corrected
+     *         symbol histograms, all zero unless built with RS_STATS
+     */
+#ifdef RS_STATS
+    rs_decoder_stats stats() const { return d_stats; }
+    void reset_stats() { d_stats = {}; }
+#else
+    rs_decoder_stats stats() const { return {}; }
+    void reset_stats() {}
+#endif
+
+private:
+    // shared state of the frame being decoded by the block tasks
+    struct frame_job
+    {
+        uint8_t* codeword;           // descrambled copy of the codeword
+        const uint8_t* reliability;  // codeword reliability or nullptr
+        uint8_t* payload;
+        uint8_t syn[RS_MAX_NBLOCKS][RS_PARITY_LEN];
+        std::atomic<int> n_corrected;
+        std::atomic<uint32_t> failed_blocks;
+    };
+
+    void decode_frame(frame_job& job);
+    void decode_block(frame_job& job, int block);
+    void extract_block(const uint8_t* codeword, uint8_t* payload, int block) const;
+    uint32_t frame_syndromes(const uint8_t* codeword, uint8_t (*syn)[RS_PARITY_LEN]);
+#ifdef RS_STATS
+    void collect_stats(uint32_t lanes, int nerrors);
+#endif
+
+    bool d_rs_decode;
+    bool d_deinterleave;
+    bool d_descramble;
+    int d_n_interleave;
+    bool d_dual_basis;
+
+    reed_solomon d_rs;
+    const randomizer* d_scrambler;
+    bool d_fecf = false;
+    // syndromes of the randomizer sequence, removed from the frame syndromes
+    uint8_t d_scrambler_syn[RS_MAX_NBLOCKS][RS_PARITY_LEN] = {{0}};
+
+    // per-frame work buffers, grown to the largest batch seen
+    std::vector<uint8_t> d_codewords;
+    std::unique_ptr<frame_job[]> d_jobs;
+    int d_jobs_len = 0;
+
+    uint32_t d_num_frames_received = 0;
+    uint32_t d_num_frames_decoded = 0;
+    uint32_t d_num_frames_fast_path = 0;
+    uint32_t d_num_frames_fecf_failed = 0;
+
+#ifdef RS_STATS
+    std::mutex d_stats_mutex;
+    rs_decoder_stats d_stats = {};
+#endif
+
+    std::unique_ptr<rs_thread_pool> d_own_pool;
+    rs_thread_pool* d_pool;
+};
+
+#endif // CCSDS_BATCH_DECODER_H
@@ -0,0 +1,151 @@
+#include "ccsds_channel_manager.h"
+
+#include <string.h>
+
+#include "ccsds.h"
+
+static uint64_t sync_word_value()
+{
+    uint64_t sync_word = 0;
+    for (int i = 0; i < SYNC_WORD_LEN; i++)
+    {
+        sync_word = (sync_word << 8) | SYNC_WORD[i];
+    }
+    return sync_word;
+}
+
+static const randomizer* scrambler_of(const ccsds_channel_manager::channel_config& config)
+{
+    return config.scrambler ? config.scrambler : &randomizer::get(RANDOMIZER_CCSDS);
+}
+
+static bool same_profile(const ccsds_channel_manager::channel_config& a,
+                         const ccsds_channel_manager::channel_config& b)
+{
+    return a.rs_code == b.rs_code && a.n_interleave == b.n_interleave && a.virtual_fill == b.virtual_fill &&
+           a.dual_basis == b.dual_basis && a.deinterleave == b.deinterleave && a.descramble == b.descramble &&
+           (!a.descramble || scrambler_of(a) == scrambler_of(b)) && a.fecf == b.fecf;
+}
+
+ccsds_channel_manager::ccsds_channel_manager(payload_callback_t on_payload, int n_threads, int batch_frames)
+    : d_on_payload(std::move(on_payload)), d_batch_frames(batch_frames), d_pool(n_threads)
+{
+}
+
+ccsds_channel_manager::~ccsds_channel_manager()
+{
+    flush();
+}
+
+ccsds_channel_manager::profile* ccsds_channel_manager::find_profile(const channel_config& config)
+{
+    for (auto& p : d_profiles)
+    {
+        if (same_profile(p->config, config)) return p.get();
+    }
+    profile* p = new profile;
+    p->config = config;
+    p->decoder.reset(new ccsds_batch_decoder(true, config.deinterleave, config.descramble, config.n_interleave,
+                                             config.dual_basis, config.rs_code, config.virtual_fill, &d_pool,
+                                             config.scrambler));
+    p->decoder->set_fecf(config.fecf);
+    d_profiles.emplace_back(p);
+    return p;
+}
+
+int ccsds_channel_manager::add_channel(const channel_config& config)
+{
+    channel* c = new channel;
+    c->prof = find_profile(config);
+    c->sync.reset(new ccsds_frame_sync(sync_word_value(), 0xffffffff, config.threshold,
+                                       c->prof->decoder->codeword_len(), false, config.verify_count,
+                                       config.flywheel_count));
+    c->stats = {};
+    c->sync_counters = {};
+    d_channels.emplace_back(c);
+    d_n_channels++;
+    return (int)d_channels.size() - 1;
+}
+
+void ccsds_channel_manager::remove_channel(int channel)
+{
+    struct channel* c = d_channels[channel].get();
+    if (c->sync)
+    {
+        c->sync_counters = c->sync->counters();
+        c->sync.reset();
+        d_n_channels--;
+    }
+}
+
+// stages the frames of the channel's input with their ASM, so that they can
+// be decoded by the profile's ccsds_batch_decoder
+void ccsds_channel_manager::sync_channel(int channel, const uint8_t* in, size_t n_bytes)
+{
+    struct channel* c = d_channels[channel].get();
+    if (!c->sync) return;
+    profile* prof = c->prof;
+    const size_t frame_len = prof->decoder->frame_len();
+    c->stats.bytes += n_bytes;
+    c->stats.frames += c->sync->process(in, n_bytes, [prof, channel, frame_len](const uint8_t* codeword, size_t len) {
+        std::lock_guard<std::mutex> lock(prof->mutex);
+        const size_t pos = prof->frames.size();
+        prof->frames.resize(pos + frame_len);
+        memcpy(&prof->frames[pos], SYNC_WORD, SYNC_WORD_LEN);
+        memcpy(&prof->frames[pos + SYNC_WORD_LEN], codeword, len);
+        prof->channels.push_back(channel);
+    });
+}
+
+void ccsds_channel_manager::push(int channel, const uint8_t* in, size_t n_bytes)
+{
+    sync_channel(channel, in, n_bytes);
+    flush_full();
+}
+
+void ccsds_channel_manager::push(const channel_input* inputs, int n_inputs)
+{
+    for (int i = 0; i < n_inputs; i++)
+    {
+        const channel_input input = inputs[i];
+        d_pool.submit([this, input]() { sync_channel(input.channel, input.data, input.n_bytes); });
+    }
+    d_pool.wait();
+    flush_full();
+}
+
+void ccsds_channel_manager::flush()
+{
+    for (auto& p : d_profiles)
+    {
+        if (!p->channels.empty()) decode_profile(p.get());
+    }
+}
+
+void ccsds_channel_manager::flush_full()
+{
+    for (auto& p : d_profiles)
+    {
+        if ((int)p->channels.size() >= d_batch_frames) decode_profile(p.get());
+    }
+}
+
+void ccsds_channel_manager::decode_profile(profile* prof)
+{
+    const int n_frames = prof->channels.size();
+    const int data_len = prof->decoder->data_len();
+    prof->payloads.resize((size_t)n_frames * data_len);
+    prof->status.resize(n_frames);
+    prof->decoder->decode(prof->frames.data(), nullptr, n_frames, prof->payloads.data(), prof->status.data());
+
+    for (int f = 0; f < n_frames; f++)
+    {
+        const int ch = prof->channels[f];
+        const ccsds_frame_status& st = prof->status[f];
+        channel_stats& stats = d_channels[ch]->stats;
+        (st.decoded ? stats.decoded : stats.failed)++;
+        d_on_payload(ch, &prof->payloads[(size_t)f * data_len], data_len, st);
+    }
+    prof->frames.clear();
+    prof->channels.clear();
+}
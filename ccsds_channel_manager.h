@@ -0,0 +1,151 @@
+#ifndef INCLUDED_CCSDS_CHANNEL_MANAGER_H
+#define INCLUDED_CCSDS_CHANNEL_MANAGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "reed_solomon.h"
+#include "rs_thread_pool.h"
+#include "frame_sync.h"
+#include "ccsds_batch_decoder.h"
+
+/**
+ * Receives many independent CCSDS links ("channels", e.g. one per
+ * spacecraft, antenna or virtual channel stream) on one shared thread pool.
+ *
+ * A channel only holds its frame synchronizer, whose buffer is one frame of
+ * the channel's configured length, and a few counters; there is no decoder
+ * per channel. The frames the channels find are staged per decoding profile
+ * (code, interleaving depth, virtual fill, dual basis, de-interleaving,
+ * randomizer and FECF), so channels with the same profile share one
+ * ccsds_batch_decoder, and are RS decoded in batches across all channels
+ * on the pool. Payloads are delivered in stream order per channel.
+ */
+class ccsds_channel_manager
+{
+public:
+    struct channel_config
+    {
+        rs_code_t rs_code = RS_CODE_255_223;
+        int n_interleave = 1;
+        int virtual_fill = 0;
+        bool dual_basis = true;
+        bool deinterleave = true;
+        bool descramble = true;
+        const randomizer* scrambler = nullptr;  // nullptr for the CCSDS one
+        bool fecf = false;       // frames that fail their FECF count as failed
+        int threshold = 2;       // ASM bits allowed to differ
+        int verify_count = 0;    // see ccsds_frame_sync
+        int flywheel_count = 0;
+    };
+
+    // a block of the packed bitstream (8 bits per byte, MSB first) of a channel
+    struct channel_input
+    {
+        int channel;
+        const uint8_t* data;
+        size_t n_bytes;
+    };
+
+    struct channel_stats
+    {
+        uint64_t bytes;    // input
+        uint64_t frames;   // found by the synchronizer
+        uint64_t decoded;
+        uint64_t failed;
+    };
+
+    // receives every frame the channels find once it is decoded (the
+    // uncorrected data if status.decoded is false), valid during the call only
+    typedef std::function<void(int channel, const uint8_t* payload, size_t len, const ccsds_frame_status& status)>
+        payload_callback_t;
+
+    /**
+     * @param on_payload   Called on the thread of push() or flush()
+     * @param n_threads    Worker threads, 0 for one per hardware thread
+     * @param batch_frames Staged frames of a profile that trigger its decoding
+     */
+    ccsds_channel_manager(payload_callback_t on_payload, int n_threads = 0, int batch_frames = 64);
+    ~ccsds_channel_manager();
+
+    ccsds_channel_manager(const ccsds_channel_manager&) = delete;
+    ccsds_channel_manager& operator=(const ccsds_channel_manager&) = delete;
+
+    /**
+     * @return Channel number, used by the other functions
+     */
+    int add_channel(const channel_config& config);
+
+    /**
+     * Frees the channel's synchronizer; its frames already found are still
+     * delivered, and its stats and sync counters keep their final values.
+     * Later pushes to the channel are ignored. Channel numbers are not
+     * reused.
+     */
+    void remove_channel(int channel);
+
+    /**
+     * Synchronizes to the next n_bytes of the channel's stream on the
+     * calling thread. Frames may span calls.
+     */
+    void push(int channel, const uint8_t* in, size_t n_bytes);
+
+    /**
+     * Same as above for many channels at once, each input is synchronized
+     * on the pool (at most one input per channel).
+     */
+    void push(const channel_input* inputs, int n_inputs);
+
+    /**
+     * Decodes and delivers the frames staged so far, e.g. to bound the
+     * latency of low-rate channels.
+     */
+    void flush();
+
+    channel_stats stats(int channel) const { return d_channels[channel]->stats; }
+    const ccsds_frame_sync::counters_t& sync_counters(int channel) const
+    {
+        const struct channel* c = d_channels[channel].get();
+        return c->sync ? c->sync->counters() : c->sync_counters;
+    }
+    size_t num_channels() const { return d_n_channels; }
+    int num_threads() const { return d_pool.size(); }
+
+private:
+    // channels of a profile share the decoder and its staging buffers
+    struct profile
+    {
+        channel_config config;
+        std::unique_ptr<ccsds_batch_decoder> decoder;
+        std::mutex mutex;
+        std::vector<uint8_t> frames;   // staged frames with their ASM, decoder->frame_len() each
+        std::vector<int> channels;     // channel of each staged frame
+        std::vector<uint8_t> payloads;
+        std::vector<ccsds_frame_status> status;
+    };
+
+    struct channel
+    {
+        std::unique_ptr<ccsds_frame_sync> sync;  // nullptr once removed
+        profile* prof;
+        channel_stats stats;
+        ccsds_frame_sync::counters_t sync_counters;  // of the freed synchronizer
+    };
+
+    profile* find_profile(const channel_config& config);
+    void sync_channel(int channel, const uint8_t* in, size_t n_bytes);
+    void decode_profile(profile* prof);
+    void flush_full();
+
+    payload_callback_t d_on_payload;
+    int d_batch_frames;
+    rs_thread_pool d_pool;
+    std::vector<std::unique_ptr<profile>> d_profiles;
+    std::vector<std::unique_ptr<channel>> d_channels;
+    size_t d_n_channels = 0;
+};
+
+#endif /* INCLUDED_CCSDS_CHANNEL_MANAGER_H */
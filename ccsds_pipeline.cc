@@ -0,0 +1,147 @@
+#include "ccsds_pipeline.h"
+
+#include <string.h>
+#include <memory>
+#include <vector>
+
+#include "viterbi27.h"
+
+// symbols decoded per call of vitfilt27_decode(): one traceback, one output byte
+#define VITERBI_CHUNK (2 * TRACECHUNK)
+
+struct soft_demod_state
+{
+    std::vector<int> sent;  // per symbol of a pattern period, C1 and C2 alternating
+    int n_sent = 0;         // sent symbols per period
+    size_t pos = 0;         // position of the next symbol in the period
+};
+
+stream_pipeline::stage_fn make_soft_demod_stage(const int* puncture_c1, const int* puncture_c2, int pattern_len)
+{
+    auto st = std::make_shared<soft_demod_state>();
+    for (int i = 0; i < pattern_len; i++)
+    {
+        st->sent.push_back(puncture_c1[i]);
+        st->sent.push_back(puncture_c2[i]);
+        st->n_sent += (puncture_c1[i] != 0) + (puncture_c2[i] != 0);
+    }
+
+    return [st](stream_batch& in, stream_batch* out) {
+        if (st->n_sent == 0) return;
+        const float* x = (const float*)in.data();
+        const size_t n = in.len / sizeof(float);
+        const size_t period = st->sent.size();
+
+        // one symbol per sample plus the erasures in between
+        uint8_t* dst = out->grow((n + 1) * period / st->n_sent + period);
+        size_t i = 0;
+        size_t n_out = 0;
+        for (;;)
+        {
+            if (!st->sent[st->pos])
+            {
+                dst[n_out++] = 128;
+            }
+            else
+            {
+                if (i == n) break;
+                int value = int((x[i++] + 1.0f) / 2.0f * 255.0f + 0.5f);
+                value = value < 0 ? 0 : value > 255 ? 255 : value;
+                dst[n_out++] = 0xff - value;
+            }
+            st->pos = st->pos + 1 == period ? 0 : st->pos + 1;
+        }
+        out->len += n_out;
+    };
+}
+
+struct viterbi_state
+{
+    v27 vi;
+    uint8_t carry[VITERBI_CHUNK];  // symbols of an incomplete chunk
+    size_t n_carry = 0;
+};
+
+stream_pipeline::stage_fn make_viterbi_stage(stream_pipeline::finish_fn* finish)
+{
+    auto st = std::make_shared<viterbi_state>();
+    memset(&st->vi, 0, sizeof(v27));
+    vitfilt27_init(&st->vi);
+
+    if (finish)
+    {
+        *finish = [st](stream_batch* out) {
+            // the carried symbols padded to a chunk, then erasures until the
+            // decoder has output the bits of all symbols
+            uint8_t erasures[2 * MERGEDIST];
+            memset(erasures, 128, sizeof(erasures));
+            uint8_t* dst = out->grow(1 + sizeof(erasures) / VITERBI_CHUNK);
+            if (st->n_carry > 0)
+            {
+                memset(&st->carry[st->n_carry], 128, VITERBI_CHUNK - st->n_carry);
+                vitfilt27_decode(&st->vi, st->carry, dst++, VITERBI_CHUNK);
+                out->len++;
+                st->n_carry = 0;
+            }
+            vitfilt27_decode(&st->vi, erasures, dst, sizeof(erasures));
+            out->len += sizeof(erasures) / VITERBI_CHUNK;
+        };
+    }
+
+    return [st](stream_batch& in, stream_batch* out) {
+        uint8_t* syms = in.data();
+        size_t n = in.len;
+        uint8_t* dst = out->grow((st->n_carry + n) / VITERBI_CHUNK);
+
+        if (st->n_carry > 0)
+        {
+            size_t c = VITERBI_CHUNK - st->n_carry < n ? VITERBI_CHUNK - st->n_carry : n;
+            memcpy(&st->carry[st->n_carry], syms, c);
+            st->n_carry += c;
+            syms += c;
+            n -= c;
+            if (st->n_carry < VITERBI_CHUNK) return;
+            vitfilt27_decode(&st->vi, st->carry, dst++, VITERBI_CHUNK);
+            out->len++;
+            st->n_carry = 0;
+        }
+
+        const size_t n_chunks = n / VITERBI_CHUNK;
+        if (n_chunks > 0)
+        {
+            vitfilt27_decode(&st->vi, syms, dst, n_chunks * VITERBI_CHUNK);
+            out->len += n_chunks;
+        }
+        st->n_carry = n - n_chunks * VITERBI_CHUNK;
+        memcpy(st->carry, &syms[n_chunks * VITERBI_CHUNK], st->n_carry);
+    };
+}
+
+stream_pipeline::stage_fn make_correlator_stage(ccsds_correlator* correlator)
+{
+    return [correlator](stream_batch& in, stream_batch* out) {
+        correlator->process_packed(in.data(), in.len, [out](const uint8_t* frame, size_t frame_len) {
+            memcpy(out->grow(frame_len), frame, frame_len);
+            out->len += frame_len;
+            out->n_items++;
+        });
+    };
+}
+
+stream_pipeline::stage_fn make_rs_decode_stage(ccsds_rs_decoder* decoder)
+{
+    return [decoder](stream_batch& in, stream_batch* out) {
+        const size_t frame_len = decoder->codeword_len();
+        for (uint32_t i = 0; i < in.n_items; i++)
+        {
+            uint8_t* codeword = &in.data()[i * frame_len];
+            const int data_len = decoder->decode_in_place(codeword);
+            if (data_len > 0)
+            {
+                memcpy(out->grow(data_len), codeword, data_len);
+                out->len += data_len;
+                out->n_items++;
+            }
+        }
+    };
+}
@@ -0,0 +1,59 @@
+#ifndef INCLUDED_CCSDS_PIPELINE_H
+#define INCLUDED_CCSDS_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stream_pipeline.h"
+#include "correlatorl.h"
+#include "ccsds_rs_decoder.h"
+
+/*
+ * Stages of a CCSDS receive chain on a stream_pipeline, in stream order:
+ *
+ *   soft demod   BPSK samples (float) -> soft symbols (uint8_t)
+ *   viterbi      soft symbols -> packed decoded bits
+ *   correlator   packed bits -> codewords (one item per codeword)
+ *   rs decode    codewords -> payloads of the decoded frames
+ *
+ * The stages keep their state between batches, so a batch may end anywhere
+ * in the stream. Descrambling and de-interleaving are part of the RS decode
+ * stage, whose decoder does both in the same pass as the block gather.
+ */
+
+/**
+ * Maps BPSK samples (+1 for a 0 bit) to 0..255 soft symbols (255 a certain
+ * 1) and re-inserts the symbols removed by puncturing as erasures (128),
+ * C1 and C2 alternating as expected by vitfilt27_decode().
+ *
+ * @param puncture_c1 1 where the C1 symbol of a bit is sent, pattern_len entries
+ * @param puncture_c2 Same for C2
+ */
+stream_pipeline::stage_fn make_soft_demod_stage(const int* puncture_c1, const int* puncture_c2, int pattern_len);
+
+/**
+ * K=7 r=1/2 Viterbi decoding (vitfilt27_decode()) of the soft symbols of
+ * make_soft_demod_stage(), packed bits out, MSB first. The output lags the
+ * input by the decoder's traceback depth.
+ *
+ * @param finish If not nullptr, set to the stage's finish function for
+ *               stream_pipeline::add_stage(): it decodes the symbols of an
+ *               incomplete chunk and pushes the last MERGEDIST bits out of
+ *               the decoder with erasures, so that a finite stream is
+ *               decoded to its end
+ */
+stream_pipeline::stage_fn make_viterbi_stage(stream_pipeline::finish_fn* finish = nullptr);
+
+/**
+ * Frames of correlator->process_packed(), back to back, without their ASM.
+ * The correlator must outlive the pipeline.
+ */
+stream_pipeline::stage_fn make_correlator_stage(ccsds_correlator* correlator);
+
+/**
+ * Decodes the codewords of make_correlator_stage() in place
+ * (decoder->decode_in_place()) and passes on the payloads of the frames
+ * that decoded, back to back. The decoder must outlive the pipeline.
+ */
+stream_pipeline::stage_fn make_rs_decode_stage(ccsds_rs_decoder* decoder);
+
+#endif /* INCLUDED_CCSDS_PIPELINE_H */
@@ -4,12 +4,23 @@
 #include <stdint.h>
 #include <string.h>
 #include "reed_solomon.h"
+#include "rs_interleave.h"
+#include "crc16.h"
 #include "ccsds.h"
 #include "ccsds_rs_decoder.h"
 
 #define STATE_SYNC_SEARCH 0
 #define STATE_CODEWORD 1
 
+static uint64_t sync_word_value()
+{
+    uint64_t sync_word = 0;
+    for (int i = 0; i < SYNC_WORD_LEN; i++)
+    {
+        sync_word = (sync_word << 8) | SYNC_WORD[i];
+    }
+    return sync_word;
+}
 
 
 ccsds_rs_decoder::ccsds_rs_decoder(int threshold,
@@ -19,20 +30,37 @@ ccsds_rs_decoder::ccsds_rs_decoder(int threshold,
                                   bool verbose,
                                   bool printing,
                                   int n_interleave,
-                                  bool dual_basis)
+                                  bool dual_basis,
+                                  rs_code_t rs_code,
+                                  int virtual_fill,
+                                  const randomizer* scrambler)
     : d_threshold(threshold), d_rs_decode(rs_decode), d_deinterleave(deinterleave), d_descramble(descramble),
-      d_verbose(verbose), d_printing(printing), d_n_interleave(n_interleave), d_dual_basis(dual_basis)
+      d_verbose(verbose), d_printing(printing), d_n_interleave(n_interleave), d_dual_basis(dual_basis),
+      d_rs(rs_code, virtual_fill),
+      d_sync(sync_word_value(), 0xffffffff, threshold, d_rs.block_len() * n_interleave, false),
+      d_scrambler(scrambler ? scrambler : &randomizer::get(RANDOMIZER_CCSDS))
 {
-    for (uint8_t i = 0; i < SYNC_WORD_LEN; i++)
+    d_sync_word = sync_word_value();
+
+    if (d_descramble)
     {
-        d_sync_word = (d_sync_word << 8) | (SYNC_WORD[i] & 0xff);
+        memset(d_codeword, 0, codeword_len());
+        d_scrambler->apply(d_codeword, codeword_len());
+        gather_blocks(d_codeword, nullptr, d_scrambler_blocks);
+        if (d_rs_decode)
+        {
+            // the randomizer is added modulo 2 to every codeword symbol and the
+            // syndromes are linear, so its contribution is a per-block constant
+            frame_syndromes(d_codeword, d_scrambler_syn);
+        }
+        memset(d_codeword, 0, codeword_len());
     }
     enter_sync_search();
 }
 
 int ccsds_rs_decoder::find_asm_and_decode(const uint8_t* in, int ninput_items, const uint8_t *out, int *noutput_items)
 {
-    uint16_t count = 0;
+    int count = 0;
     while (count < ninput_items)
     {
         switch (d_decoder_state)
@@ -63,7 +91,7 @@ int ccsds_rs_decoder::find_asm_and_decode(const uint8_t* in, int ninput_items, c
                     if (d_verbose) printf("\tloaded codeword of length %i\n", codeword_len());
                     if (d_printing) print_bytes(d_codeword, codeword_len());
 
-                    bool success = decode_frame();
+                    bool success = decode_frame(d_codeword, d_payload);
 
                     if (success)
                     {
@@ -71,7 +99,7 @@ int ccsds_rs_decoder::find_asm_and_decode(const uint8_t* in, int ninput_items, c
                         *noutput_items = data_len();
                         if (d_verbose)
                         {
-                            printf("\tframes received: %i\n\tframes decoded: %i\n\tsubframes decoded: %i\n", d_num_frames_received, d_num_frames_decoded, d_num_subframes_decoded);
+                            printf("\tframes received: %i\n\tframes decoded: %i\n\tsubframes decoded: %i\n\tframes on fast path: %i\n", d_num_frames_received, d_num_frames_decoded, d_num_subframes_decoded, d_num_frames_fast_path);
                         }
                     }
                     enter_sync_search();
@@ -84,6 +112,11 @@ int ccsds_rs_decoder::find_asm_and_decode(const uint8_t* in, int ninput_items, c
 }
 
 int ccsds_rs_decoder::decode_aligned_bytes(const uint8_t* in_bytes, int n_bytes, uint8_t* out, int* noutput_items)
+{
+    return decode_aligned_bytes(in_bytes, nullptr, n_bytes, out, noutput_items);
+}
+
+int ccsds_rs_decoder::decode_aligned_bytes(const uint8_t* in_bytes, const uint8_t* reliability, int n_bytes, uint8_t* out, int* noutput_items)
 {
     if (n_bytes < codeword_len())
     {
@@ -104,12 +137,11 @@ int ccsds_rs_decoder::decode_aligned_bytes(const uint8_t* in_bytes, int n_bytes,
             print_bytes(d_codeword, codeword_len());
     }
 
-    bool success = decode_frame();
+    // the payload is extracted straight to out
+    bool success = decode_frame(d_codeword, out, reliability ? &reliability[SYNC_WORD_LEN] : nullptr);
 
     if (success)
     {
-        // TODO: remove unnecessary copy
-        memcpy(out, d_payload, data_len());
         *noutput_items = data_len();
         d_num_frames_decoded++;
         d_num_subframes_decoded++;  // optional, if subframes are used
@@ -122,6 +154,40 @@ int ccsds_rs_decoder::decode_aligned_bytes(const uint8_t* in_bytes, int n_bytes,
     }
 }
 
+int ccsds_rs_decoder::find_asm_and_decode_packed(const uint8_t* in, int n_bytes, uint8_t* out, int* noutput_items)
+{
+    *noutput_items = 0;
+    d_sync.process(in, n_bytes, [&](const uint8_t* frame, size_t frame_len) {
+        if (d_verbose) printf("\tloaded codeword of length %i\n", codeword_len());
+        d_num_frames_received++;
+        memcpy(d_codeword, frame, frame_len);
+        if (d_printing) print_bytes(d_codeword, codeword_len());
+
+        if (decode_frame(d_codeword, &out[*noutput_items]))
+        {
+            *noutput_items += data_len();
+        }
+    });
+    return n_bytes;
+}
+
+int ccsds_rs_decoder::find_asm_and_decode_packed(const uint8_t* in, int n_bytes, frame_ring* ring)
+{
+    return d_sync.process(in, n_bytes, ring, [&](uint8_t* frame, size_t* frame_len) {
+        if (d_verbose) printf("\tloaded codeword of length %i\n", codeword_len());
+        d_num_frames_received++;
+        if (d_printing) print_bytes(frame, codeword_len());
+
+        *frame_len = data_len();
+        return decode_frame(frame, frame);
+    });
+}
+
+int ccsds_rs_decoder::decode_in_place(uint8_t* codeword, const uint8_t* reliability)
+{
+    return decode_frame(codeword, codeword, reliability) ? data_len() : 0;
+}
+
 void ccsds_rs_decoder::enter_sync_search()
 {
     if (d_verbose) printf("enter sync search\n");
@@ -144,33 +210,127 @@ bool ccsds_rs_decoder::compare_sync_word()
     return nwrong <= d_threshold;
 }
 
-bool ccsds_rs_decoder::decode_frame()
+uint32_t ccsds_rs_decoder::frame_syndromes(const uint8_t* codeword, uint8_t (*syn)[RS_PARITY_LEN])
 {
-    bool success = true;
-
-    if (d_descramble)
+    if (d_deinterleave)
     {
-        descramble(d_codeword, codeword_len());
+        return d_rs.syndromes(codeword, d_n_interleave, syn, d_dual_basis);
     }
 
-    uint8_t rs_block[RS_BLOCK_LEN];
-    int8_t nerrors;
+    uint32_t dirty = 0;
     for (uint8_t i = 0; i < d_n_interleave; i++)
     {
-        for (uint8_t j = 0; j < RS_BLOCK_LEN; j++)
+        dirty |= d_rs.syndromes(&codeword[i * d_rs.block_len()], 1, &syn[i], d_dual_basis) << i;
+    }
+    return dirty;
+}
+
+// blocks[i] = RS block i of the codeword (interleaved or one block after the
+// other) plus the sequence seq[i], if any, in one pass
+void ccsds_rs_decoder::gather_blocks(const uint8_t* codeword, const uint8_t* seq,
+                                     uint8_t (*blocks)[RS_BLOCK_LEN]) const
+{
+    const int n = d_rs.block_len();
+    if (d_deinterleave)
+    {
+        rs_deinterleave(codeword, d_n_interleave, n, seq, blocks[0], RS_BLOCK_LEN);
+        return;
+    }
+    for (int i = 0; i < d_n_interleave; i++)
+    {
+        rs_deinterleave(&codeword[i * n], 1, n, seq ? &seq[i * RS_BLOCK_LEN] : nullptr, blocks[i], RS_BLOCK_LEN);
+    }
+}
+
+// payload may be codeword: on the fast path the data symbols of block i
+// only ever move to lower offsets than those of the blocks after it, which
+// are read first
+bool ccsds_rs_decoder::decode_frame(uint8_t* codeword, uint8_t* payload, const uint8_t* reliability)
+{
+    bool success = true;
+    const int n = d_rs.block_len();
+    const int k = d_rs.data_len();
+
+    // syndromes of all blocks in one pass over the (still randomized) codeword
+    uint8_t syn[RS_MAX_NBLOCKS][RS_PARITY_LEN];
+    uint32_t dirty = 0;
+    if (d_rs_decode)
+    {
+        dirty = frame_syndromes(codeword, syn);
+        if (d_descramble)
+        {
+            dirty = 0;
+            for (uint8_t i = 0; i < d_n_interleave; i++)
+            {
+                uint8_t any = 0;
+                for (uint8_t j = 0; j < d_rs.parity_len(); j++)
+                {
+                    syn[i][j] ^= d_scrambler_syn[i][j];
+                    any |= syn[i][j];
+                }
+                if (any) dirty |= 1u << i;
+            }
+        }
+
+        if (!dirty)
         {
+            // every block is a valid codeword, only the payload is extracted
+            if (d_verbose) printf("\tall rs blocks clean\n");
+            // derandomized on the way into payload, which may be codeword
             if (d_deinterleave)
             {
-                rs_block[j] = d_codeword[i + (j * d_n_interleave)];
+                if (d_descramble)
+                    d_scrambler->apply(codeword, data_len(), 0, payload);
+                else if (payload != codeword)
+                    memcpy(payload, codeword, data_len());
             }
             else
             {
-                rs_block[j] = d_codeword[i * RS_BLOCK_LEN + j];
+                for (uint8_t i = 0; i < d_n_interleave; i++)
+                {
+                    if (d_descramble)
+                        d_scrambler->apply(&codeword[i * n], k, i * n, &payload[i * k]);
+                    else
+                        memmove(&payload[i * k], &codeword[i * n], k);
+                }
             }
+#ifdef RS_STATS
+            for (int i = 0; i < d_n_interleave; i++) d_stats.record(i, 0);
+            rs_stats_collect(d_stats);
+#endif
+            if (!check_fecf(payload)) return false;
+            d_num_subframes_decoded += d_n_interleave;
+            d_num_frames_fast_path++;
+            d_num_frames_decoded++;
+            return true;
         }
+    }
+
+    // the codeword is descrambled and split into its RS blocks in one pass
+    uint8_t rs_blocks[RS_MAX_NBLOCKS][RS_BLOCK_LEN];
+    uint8_t rs_reliability[RS_MAX_NBLOCKS][RS_BLOCK_LEN];
+    gather_blocks(codeword, d_descramble ? d_scrambler_blocks[0] : nullptr, rs_blocks);
+    if (reliability && dirty) gather_blocks(reliability, nullptr, rs_reliability);
+
+    int8_t nerrors;
+    int n_subframes = 0;
+    for (uint8_t i = 0; i < d_n_interleave; i++)
+    {
         if (d_rs_decode)
         {
-            nerrors = d_rs.decode(rs_block, d_dual_basis);
+            nerrors = 0;
+            if (dirty & (1u << i))
+            {
+                if (reliability)
+                {
+                    nerrors = d_rs.decode_with_syndromes(rs_blocks[i], syn[i], rs_reliability[i], d_dual_basis);
+                }
+                else
+                {
+                    nerrors = d_rs.decode_with_syndromes(rs_blocks[i], syn[i], d_dual_basis);
+                }
+            }
+            RS_STATS_RECORD(d_stats, i, nerrors);
             if (nerrors == -1)
             {
                 if (d_verbose) printf("\tcould not decode rs block #%i\n", i);
@@ -179,23 +339,38 @@ bool ccsds_rs_decoder::decode_frame()
             else
             {
                 if (d_verbose) printf("\tdecoded rs block #%i with %i errors\n", i, nerrors);
-                d_num_subframes_decoded++;
+                n_subframes++;
             }
         }
-        if (d_deinterleave)
-        {
-            for (uint8_t j = 0; j < RS_DATA_LEN; j++)
-            {
-                d_payload[i + (j * d_n_interleave)] = rs_block[j];
-            }
-        }
-        else
+    }
+
+    // payload may be codeword, which was read completely above
+    if (d_deinterleave)
+    {
+        rs_interleave(rs_blocks[0], RS_BLOCK_LEN, d_n_interleave, k, payload);
+    }
+    else
+    {
+        for (uint8_t i = 0; i < d_n_interleave; i++)
         {
-            memcpy(&d_payload[i * RS_DATA_LEN], rs_block, RS_DATA_LEN);
+            memcpy(&payload[i * k], rs_blocks[i], k);
         }
     }
 
+    RS_STATS_COLLECT(d_stats);
+    // the RS blocks of a frame that fails the FECF don't count as decoded
+    if (success) success = check_fecf(payload);
     if (success) d_num_frames_decoded++;
+    if (success || n_subframes < d_n_interleave) d_num_subframes_decoded += n_subframes;
 
     return success;
-}
\ No newline at end of file
+}
+
+// true unless FECF checking is on and the payload fails it
+bool ccsds_rs_decoder::check_fecf(const uint8_t* payload)
+{
+    if (!d_fecf || fecf_check(payload, data_len())) return true;
+    if (d_verbose) printf("\tFECF mismatch\n");
+    d_num_frames_fecf_failed++;
+    return false;
+}
@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 #include "reed_solomon.h"
+#include "rs_stats.h"
+#include "frame_sync.h"
+#include "randomizer.h"
 #include "ccsds.h"
 
 class ccsds_rs_decoder {
@@ -14,24 +17,121 @@ public:
                      bool verbose,
                      bool printing,
                      int n_interleave,
-                     bool dual_basis);
+                     bool dual_basis,
+                     rs_code_t rs_code = RS_CODE_255_223,
+                     int virtual_fill = 0,
+                     const randomizer* scrambler = nullptr);
     ~ccsds_rs_decoder() = default;
 
     int find_asm_and_decode(const uint8_t* in, int ninput_items, const uint8_t* out, int* noutput_items);
+    // the payload is extracted straight to out, which is also written to
+    // when the frame can't be decoded (*noutput_items 0)
     int decode_aligned_bytes(const uint8_t* in_bytes, int n_bytes, uint8_t* out, int* noutput_items);
 
+    /**
+     * Same as find_asm_and_decode() for a packed bitstream (8 bits per byte,
+     * MSB first). Codewords are found by a ccsds_frame_sync: the ASM is
+     * searched at all bit offsets with a 64-bit window sliding a byte at a
+     * time and, once locked, only tested at the expected frame boundary (see
+     * set_sync_counts()). Frames may span calls. Don't mix with
+     * find_asm_and_decode() on the same decoder.
+     *
+     * @param out           Payloads of all frames decoded in this call, back
+     *                      to back, data_len() bytes each
+     * @param noutput_items Number of bytes written to out
+     * @return              Number of input bytes consumed, always n_bytes
+     */
+    int find_asm_and_decode_packed(const uint8_t* in, int n_bytes, uint8_t* out, int* noutput_items);
+
+    /**
+     * Same as above, the codewords are assembled straight into the slots of
+     * ring (slot_size() >= codeword length), decoded in place and published
+     * with their payload at the start of the slot. Frames that fail to
+     * decode aren't published. Don't mix with the other versions.
+     *
+     * @return Number of frames published
+     */
+    int find_asm_and_decode_packed(const uint8_t* in, int n_bytes, frame_ring* ring);
+
+    /**
+     * Same as decode_aligned_bytes() above, with errors-and-erasures
+     * decoding of the RS blocks.
+     *
+     * @param reliability One value per input byte (same indexing as in_bytes),
+     *                    e.g. the minimum soft magnitude over the byte's bits.
+     *                    The least reliable bytes of a block that can't be
+     *                    corrected otherwise are declared erased.
+     */
+    int decode_aligned_bytes(const uint8_t* in_bytes, const uint8_t* reliability, int n_bytes, uint8_t* out, int* noutput_items);
+
+    /**
+     * Decodes a codeword (without ASM) in place, the payload replaces its
+     * first data bytes.
+     *
+     * @param reliability Optional, one value per codeword byte, see above
+     * @return            Payload length, 0 if the frame couldn't be decoded
+     */
+    int decode_in_place(uint8_t* codeword, const uint8_t* reliability = nullptr);
+
+    /**
+     * Upper bound on the erasures per RS block, see reed_solomon::set_max_erasures().
+     */
+    void set_max_erasures(int max_erasures) { d_rs.set_max_erasures(max_erasures); }
+
+    /**
+     * Set the ASMs find_asm_and_decode_packed() verifies before it locks and
+     * the missing ASMs it flywheels over once locked, both 0 by default.
+     */
+    void set_sync_counts(int verify_count, int flywheel_count)
+    {
+        d_sync.set_verify_count(verify_count);
+        d_sync.set_flywheel_count(flywheel_count);
+    }
+
+    /**
+     * Checks the Frame Error Control Field of every frame after RS decoding
+     * (see ccsds_rs_encoder::set_fecf()), frames that fail it count as not
+     * decoded and aren't delivered. With rs_decode off this is the only
+     * check. Off by default.
+     */
+    void set_fecf(bool fecf) { d_fecf = fecf; }
+
+    /**
+     * Frame synchronizer state counters of find_asm_and_decode_packed().
+     */
+    const ccsds_frame_sync::counters_t& sync_counters() const { return d_sync.counters(); }
+
+    inline int data_len() const { return d_rs.data_len() * d_n_interleave; }
+    inline int codeword_len() const { return d_rs.block_len() * d_n_interleave; }
+
     uint32_t num_frames_received() const { return d_num_frames_received; }
     uint32_t num_frames_decoded()  const { return d_num_frames_decoded; }
+    // RS blocks decoded, not counting those of frames that fail the FECF
     uint32_t num_subframes_decoded() const { return d_num_subframes_decoded; }
+    uint32_t num_frames_fast_path() const { return d_num_frames_fast_path; }
+    uint32_t num_frames_fecf_failed() const { return d_num_frames_fecf_failed; }
+
+    /**
+     * @return Per-stage timings and corrected symbol histograms of the RS
+     *         decoding so far, all zero unless built with RS_STATS
+     */
+#ifdef RS_STATS
+    rs_decoder_stats stats() const { return d_stats; }
+    void reset_stats() { d_stats = {}; }
+#else
+    rs_decoder_stats stats() const { return {}; }
+    void reset_stats() {}
+#endif
 
 private:
     void enter_sync_search();
     void enter_codeword();
     bool compare_sync_word();
-    bool decode_frame();
+    bool decode_frame(uint8_t* codeword, uint8_t* payload, const uint8_t* reliability = nullptr);
+    bool check_fecf(const uint8_t* payload);
+    uint32_t frame_syndromes(const uint8_t* codeword, uint8_t (*syn)[RS_PARITY_LEN]);
+    void gather_blocks(const uint8_t* codeword, const uint8_t* seq, uint8_t (*blocks)[RS_BLOCK_LEN]) const;
 
-    inline int data_len() const { return RS_DATA_LEN * d_n_interleave; }
-    inline int codeword_len() const { return RS_BLOCK_LEN * d_n_interleave; }
 
     int d_threshold;
     bool d_rs_decode;
@@ -51,12 +151,24 @@ private:
 
     uint8_t d_codeword[CODEWORD_MAX_LEN] = {0};
     uint8_t d_payload[DATA_MAX_LEN] = {0};
+    // syndromes of the randomizer sequence, removed from the frame syndromes
+    uint8_t d_scrambler_syn[RS_MAX_NBLOCKS][RS_PARITY_LEN] = {{0}};
+    // the randomizer sequence of each RS block, see gather_blocks()
+    uint8_t d_scrambler_blocks[RS_MAX_NBLOCKS][RS_BLOCK_LEN] = {{0}};
 
     uint32_t d_num_frames_received = 0;
     uint32_t d_num_frames_decoded = 0;
     uint32_t d_num_subframes_decoded = 0;
+    uint32_t d_num_frames_fast_path = 0;
+    uint32_t d_num_frames_fecf_failed = 0;
 
     reed_solomon d_rs;
+    ccsds_frame_sync d_sync;
+    const randomizer* d_scrambler;
+    bool d_fecf = false;
+#ifdef RS_STATS
+    rs_decoder_stats d_stats = {};
+#endif
 };
 
 #endif // CCSDS_RS_DECODER_H
\ No newline at end of file
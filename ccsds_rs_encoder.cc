@@ -5,60 +5,86 @@
 #include <string.h>
 #include "ccsds.h"
 #include "reed_solomon.h"
+#include "randomizer.h"
+#include "crc16.h"
 #include "ccsds_rs_encoder.h"
 
 
 ccsds_rs_encoder::ccsds_rs_encoder(bool rs_encode, bool interleave, bool scramble,
-                             bool printing, bool verbose, int n_interleave, bool dual_basis)
+                             bool printing, bool verbose, int n_interleave, bool dual_basis,
+                             rs_code_t rs_code, int virtual_fill, const randomizer* scrambler)
     : d_rs_encode(rs_encode), d_interleave(interleave), d_scramble(scramble),
       d_printing(printing), d_verbose(verbose),
-      d_n_interleave(n_interleave), d_dual_basis(dual_basis)
+      d_n_interleave(n_interleave), d_dual_basis(dual_basis), d_rs(rs_code, virtual_fill),
+      d_scrambler(scrambler ? scrambler : &randomizer::get(RANDOMIZER_CCSDS))
 {
-    memcpy(d_pkt.sync_word, SYNC_WORD, SYNC_WORD_LEN);
+}
+
+// copies len codeword bytes at offset, randomized if configured; in may be out
+void ccsds_rs_encoder::emit(const uint8_t* in, int len, int offset, uint8_t* out) const
+{
+    if (d_scramble)
+    {
+        d_scrambler->apply(in, len, offset, out);
+    }
+    else if (in != out)
+    {
+        memcpy(out, in, len);
+    }
 }
 
 int ccsds_rs_encoder::encode(const uint8_t* in, uint8_t* out)
 {
     if (!in || !out) return 0;
 
-    uint8_t rs_block[RS_BLOCK_LEN];
-    for (uint8_t i = 0; i < d_n_interleave; i++)
+    if (d_fecf)
     {
-        if (d_interleave)
-        {
-            for (uint8_t j = 0; j < RS_BLOCK_LEN; j++)
-            {
-                rs_block[j] = in[i + (d_n_interleave * j)];
-            }
-        }
-        else
-        {
-            memcpy(rs_block, &in[i * RS_DATA_LEN], RS_DATA_LEN);
-        }
+        memcpy(d_frame, in, data_len() - FECF_LEN);
+        fecf_append(d_frame, data_len());
+        in = d_frame;
+    }
 
+    // the CADU is written once: the parity is computed from in straight into
+    // its place in out, the data symbols are randomized on their way into
+    // out and the parity where it is
+    memcpy(out, SYNC_WORD, SYNC_WORD_LEN);
+    uint8_t* codeword = &out[SYNC_WORD_LEN];
+    if (d_interleave)
+    {
+        // the interleaved data rows are already in transmission order and
+        // the parity rows are generated straight behind them
+        uint8_t* parity = &codeword[data_len()];
+        const int parity_len = d_rs.parity_len() * d_n_interleave;
         if (d_rs_encode)
         {
-            d_rs.encode(rs_block, d_dual_basis);
-        }
-        else
-        {
-            memset(&rs_block[RS_DATA_LEN], 0, RS_PARITY_LEN);
-        }
-
-        if (d_interleave)
-        {
-            for (uint8_t j = 0; j < RS_BLOCK_LEN; j++)
-                d_pkt.codeword[i + (d_n_interleave * j)] = rs_block[j];
+            d_rs.encode_interleaved(in, parity, d_n_interleave, d_dual_basis);
         }
         else
         {
-            memcpy(&d_pkt.codeword[i * RS_BLOCK_LEN], rs_block, RS_BLOCK_LEN);
+            memset(parity, 0, parity_len);
         }
+        emit(in, data_len(), 0, codeword);
+        emit(parity, parity_len, data_len(), parity);
     }
-
-    if (d_scramble)
+    else
     {
-        scramble(d_pkt.codeword, codeword_len());
+        for (uint8_t i = 0; i < d_n_interleave; i++)
+        {
+            const uint8_t *data = &in[i * d_rs.data_len()];
+            uint8_t *rs_block = &codeword[i * d_rs.block_len()];
+            uint8_t *parity = &rs_block[d_rs.data_len()];
+
+            if (d_rs_encode)
+            {
+                d_rs.encode_interleaved(data, parity, 1, d_dual_basis);
+            }
+            else
+            {
+                memset(parity, 0, d_rs.parity_len());
+            }
+            emit(data, d_rs.data_len(), i * d_rs.block_len(), rs_block);
+            emit(parity, d_rs.parity_len(), i * d_rs.block_len() + d_rs.data_len(), parity);
+        }
     }
 
     d_num_frames++;
@@ -70,9 +96,8 @@ int ccsds_rs_encoder::encode(const uint8_t* in, uint8_t* out)
 
     if (d_printing)
     {
-        print_bytes(d_pkt.codeword, codeword_len());
+        print_bytes(codeword, codeword_len());
     }
 
-    memcpy(out, &d_pkt, total_frame_len());
     return total_frame_len();
 }
\ No newline at end of file
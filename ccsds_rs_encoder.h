@@ -3,12 +3,18 @@
 
 #include <stdint.h>
 #include "reed_solomon.h"
+#include "randomizer.h"
 #include "ccsds.h"
 
 class ccsds_rs_encoder {
 public:
     /**
      * Constructor for CCSDS encoder
+     *
+     * @param virtual_fill Shortens every RS codeword by this many virtual
+     *                     fill symbols, see reed_solomon
+     * @param scrambler    Randomizer used if scramble is set, nullptr for the
+     *                     CCSDS one; must outlive the encoder
      */
     ccsds_rs_encoder(bool rs_encode,
                   bool interleave,
@@ -16,29 +22,41 @@ public:
                   bool printing,
                   bool verbose,
                   int n_interleave,
-                  bool dual_basis);
+                  bool dual_basis,
+                  rs_code_t rs_code = RS_CODE_255_223,
+                  int virtual_fill = 0,
+                  const randomizer* scrambler = nullptr);
 
     ~ccsds_rs_encoder() = default;
 
     /**
      * Encodes an input payload into a CCSDS frame.
      *
-     * @param in_payload   Pointer to input data (size = RS_DATA_LEN * n_interleave)
-     * @param out_frame    Output buffer to hold the encoded frame (must be at least SYNC_WORD_LEN + RS_BLOCK_LEN * n_interleave)
+     * @param in_payload   Pointer to input data (size = data_len())
+     * @param out_frame    Output buffer to hold the encoded frame (must be at least total_frame_len()),
+     *                     written once, must not overlap in_payload
      * @return             Total number of bytes written to the output buffer
      */
     int encode(const uint8_t* in_payload, uint8_t* out_frame);
 
+    /**
+     * Closes every frame with a Frame Error Control Field: the last
+     * FECF_LEN bytes of each payload are replaced by the CRC-16 (see
+     * crc16_ccitt()) of the bytes before, ahead of RS encoding and
+     * randomization. Off by default.
+     */
+    void set_fecf(bool fecf) { d_fecf = fecf; }
+
     /**
      * @return Number of frames transmitted
      */
     uint32_t num_frames() const { return d_num_frames; }
 
-private:
-    inline int data_len() const { return RS_DATA_LEN * d_n_interleave; }
-    inline int codeword_len() const { return RS_BLOCK_LEN * d_n_interleave; }
+    inline int data_len() const { return d_rs.data_len() * d_n_interleave; }
+    inline int codeword_len() const { return d_rs.block_len() * d_n_interleave; }
     inline int total_frame_len() const { return SYNC_WORD_LEN + codeword_len(); }
 
+private:
     bool d_rs_encode;
     bool d_interleave;
     bool d_scramble;
@@ -48,8 +66,12 @@ private:
     bool d_dual_basis;
 
     reed_solomon d_rs;
-    struct ccsds_tx_pkt d_pkt;
+    const randomizer* d_scrambler;
+    bool d_fecf = false;
+    // the payload with its FECF, which is part of the RS data
+    uint8_t d_frame[DATA_MAX_LEN];
 
+    void emit(const uint8_t* in, int len, int offset, uint8_t* out) const;
 
     uint32_t d_num_frames = 0;
 };
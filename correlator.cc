@@ -4,56 +4,32 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include "correlatorl.h"
 
-
-class ccsds_correlator
-{
-public:
-    enum state_t { SEARCH, LOCK };
-    enum ambiguity_t { NONE, INVERTED };
-
-    ccsds_correlator(uint64_t asm_word, uint64_t asm_mask, uint8_t threshold, size_t frame_len);
-    ~ccsds_correlator();
-
-    int process(const uint8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready);
-    uint64_t frame_count() const { return d_frame_count; }
-
-private:
-    bool check_asm(uint64_t asm_buf);
-    void enter_state(state_t state);
-
-    uint64_t d_asm;
-    uint64_t d_asm_mask;
-    uint8_t d_threshold;
-    size_t d_frame_len;
-
-    uint64_t d_asm_buf = 0;
-    uint8_t d_byte_buf = 0;
-    uint8_t d_bit_ctr = 0;
-    uint8_t* d_frame_buffer = nullptr;
-    size_t d_frame_buffer_len = 0;
-    uint64_t d_frame_count = 0;
-
-    state_t d_state = SEARCH;
-    ambiguity_t d_ambiguity = NONE;
-};
+// symbols searched per find_sync_soft() call
+#define SOFT_CHUNK 4096
 
 ccsds_correlator::ccsds_correlator(uint64_t asm_word, uint64_t asm_mask, uint8_t threshold, size_t frame_len)
-    : d_asm(asm_word), d_asm_mask(asm_mask), d_threshold(threshold), d_frame_len(frame_len)
+    : d_asm(asm_word), d_asm_mask(asm_mask), d_threshold(threshold), d_frame_len(frame_len),
+      d_sync(asm_word, asm_mask, threshold, frame_len, true)
 {
     d_frame_buffer = (uint8_t*) malloc(frame_len * sizeof(uint8_t));
+    d_soft_buf = (int8_t*) malloc(SOFT_SYNC_MAX_LEN - 1 + SOFT_CHUNK);
+    make_soft_sync_pattern(asm_word, asm_mask, &d_soft_pattern);
+    d_soft_threshold = 1.0f - (2.0f * threshold + 1.0f) / d_soft_pattern.n_taps;
     enter_state(SEARCH);
 }
 
 ccsds_correlator::~ccsds_correlator()
 {
     free(d_frame_buffer);
+    free(d_soft_buf);
 }
 
 int ccsds_correlator::process(const uint8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready)
 {
     *frame_ready = false;
-    uint64_t count = 0;
+    int count = 0;
     while (count < ninput_items)
     {
         switch (d_state)
@@ -104,6 +80,104 @@ int ccsds_correlator::process(const uint8_t* in, int ninput_items, uint8_t* out_
     return count;
 }
 
+int ccsds_correlator::process_soft(const int8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready)
+{
+    return process_soft_symbols(in, ninput_items, out_frame, frame_ready);
+}
+
+int ccsds_correlator::process_soft(const uint8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready)
+{
+    return process_soft_symbols(in, ninput_items, out_frame, frame_ready);
+}
+
+template <typename T>
+int ccsds_correlator::process_soft_symbols(const T* in, int ninput_items, uint8_t* out_frame, bool* frame_ready)
+{
+    const int len = d_soft_pattern.len;
+    *frame_ready = false;
+    int count = 0;
+    while (count < ninput_items)
+    {
+        switch (d_state)
+        {
+            case SEARCH:
+            {
+                // the windows ending in the next chunk of the input
+                const int n = ninput_items - count < SOFT_CHUNK ? ninput_items - count : SOFT_CHUNK;
+                for (int i = 0; i < n; i++)
+                {
+                    d_soft_buf[d_soft_hist + i] = soft_symbol(in[count + i]);
+                }
+                const int n_symbols = d_soft_hist + n;
+                if (n_symbols < len)
+                {
+                    d_soft_hist = n_symbols;
+                    count += n;
+                    break;
+                }
+
+                float correlation;
+                const size_t n_windows = n_symbols - len + 1;
+                const size_t w = find_sync_soft(d_soft_buf, n_windows, d_soft_pattern, d_soft_threshold, &correlation);
+                if (w < n_windows)
+                {
+                    count += w + len - d_soft_hist;
+                    d_ambiguity = correlation < 0 ? INVERTED : NONE;
+                    enter_state(LOCK);
+                    break;
+                }
+                memmove(d_soft_buf, &d_soft_buf[n_symbols - (len - 1)], len - 1);
+                d_soft_hist = len - 1;
+                count += n;
+                break;
+            }
+            case LOCK:
+            {
+                d_byte_buf = (d_byte_buf << 1) | (soft_symbol(in[count++]) > 0);
+                d_bit_ctr++;
+                if (d_bit_ctr == 8)
+                {
+                    d_frame_buffer[d_frame_buffer_len++] = d_ambiguity == NONE ? d_byte_buf : d_byte_buf ^ 0xff;
+                    d_bit_ctr = 0;
+                }
+                if (d_frame_buffer_len == d_frame_len)
+                {
+                    memcpy(out_frame, d_frame_buffer, d_frame_len);
+                    *frame_ready = true;
+                    d_frame_count++;
+                    enter_state(SEARCH);
+                    return count; // return after one complete frame
+                }
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+int ccsds_correlator::process_packed(const uint8_t* in, size_t n_bytes, const frame_callback_t& on_frame)
+{
+    int n_frames = d_sync.process(in, n_bytes, on_frame);
+    d_frame_count += n_frames;
+    d_ambiguity = d_sync.inverted() ? INVERTED : NONE;
+    return n_frames;
+}
+
+int ccsds_correlator::process_packed(const uint8_t* in, size_t n_bytes, frame_ring* ring)
+{
+    int n_frames = d_sync.process(in, n_bytes, ring);
+    d_frame_count += n_frames;
+    d_ambiguity = d_sync.inverted() ? INVERTED : NONE;
+    return n_frames;
+}
+
+std::vector<sync_candidate> ccsds_correlator::find_candidates(const uint8_t* in, size_t n_bytes) const
+{
+    std::vector<sync_candidate> candidates;
+    find_sync_candidates(in, n_bytes, d_asm, d_asm_mask, d_threshold, true, &candidates);
+    return candidates;
+}
+
 bool ccsds_correlator::check_asm(uint64_t asm_buf)
 {
     uint64_t syndrome = (asm_buf ^ d_asm) & d_asm_mask;
@@ -120,6 +194,7 @@ void ccsds_correlator::enter_state(state_t state)
         case SEARCH:
         {
             d_asm_buf = 0;
+            d_soft_hist = 0;
             break;
         }
         case LOCK:
@@ -4,6 +4,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <functional>
+#include <vector>
+#include "bitstream.h"
+#include "soft_sync.h"
+#include "frame_sync.h"
 
 // Standalone CCSDS Correlator (no GNU Radio)
 
@@ -12,6 +17,9 @@ public:
     enum state_t { SEARCH, LOCK };
     enum ambiguity_t { NONE, INVERTED };
 
+    // receives each frame found by process_packed(), valid during the call only
+    typedef std::function<void(const uint8_t* frame, size_t frame_len)> frame_callback_t;
+
     ccsds_correlator(uint64_t asm_word, uint64_t asm_mask, uint8_t threshold, size_t frame_len);
     ~ccsds_correlator();
 
@@ -26,14 +34,98 @@ public:
      */
     int process(const uint8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready);
 
+    /**
+     * Same as process() for soft symbols: the ASM is found by its normalized
+     * correlation with the symbols (find_sync_soft()) instead of the Hamming
+     * distance of hard decisions, a negative correlation meaning an inverted
+     * frame. The frame bits are the signs of the symbols. Don't mix with the
+     * other process functions on the same correlator.
+     *
+     * @param in            Soft symbols, positive for a 1 bit
+     * @param ninput_items  Number of input symbols
+     * @param out_frame     Pointer to buffer where decoded frame will be written
+     * @param frame_ready   Set to true if a complete frame is detected and copied to out_frame
+     * @return              Number of symbols consumed
+     */
+    int process_soft(const int8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready);
+
+    /**
+     * Same as above for 0..255 soft bytes (255 a certain 1, 128 an erasure).
+     */
+    int process_soft(const uint8_t* in, int ninput_items, uint8_t* out_frame, bool* frame_ready);
+
+    /**
+     * Set the minimum normalized correlation, 0..1, of process_soft(). The
+     * default 1 - (2 * threshold + 1) / (ASM bits) accepts hard decisions
+     * with up to threshold wrong bits, like process().
+     */
+    void set_soft_threshold(float threshold) { d_soft_threshold = threshold; }
+
+    /**
+     * Same as process() for a packed bitstream (8 bits per byte, MSB first),
+     * returning every frame of the buffer in one call. Frames are found by a
+     * ccsds_frame_sync: once locked, the ASM is only tested at the expected
+     * frame boundary (see set_sync_counts()). Frames may span calls. Don't
+     * mix with process() on the same correlator.
+     *
+     * @param in        Packed input bytes
+     * @param n_bytes   Number of input bytes
+     * @param on_frame  Called with every complete frame
+     * @return          Number of frames found
+     */
+    int process_packed(const uint8_t* in, size_t n_bytes, const frame_callback_t& on_frame);
+
+    /**
+     * Same as above, the frames are written straight into the slots of ring
+     * (slot_size() >= frame_len) and published there for the consumer.
+     *
+     * @return          Number of frames published
+     */
+    int process_packed(const uint8_t* in, size_t n_bytes, frame_ring* ring);
+
+    /**
+     * Bulk search mode for initial acquisition, e.g. of a recorded pass: the
+     * masked Hamming distance to the ASM, either polarity, at every bit
+     * offset of a packed buffer (see find_sync_candidates()). Independent of
+     * the state of process() and process_packed().
+     *
+     * @param in        Packed input bytes
+     * @param n_bytes   Number of input bytes
+     * @return          Offsets within the threshold (bit following the ASM),
+     *                  best first
+     */
+    std::vector<sync_candidate> find_candidates(const uint8_t* in, size_t n_bytes) const;
+
+    /**
+     * Set the ASMs process_packed() verifies before it locks and the missing
+     * ASMs it flywheels over once locked, both 0 by default.
+     */
+    void set_sync_counts(int verify_count, int flywheel_count)
+    {
+        d_sync.set_verify_count(verify_count);
+        d_sync.set_flywheel_count(flywheel_count);
+    }
+
+    /**
+     * Frame synchronizer state counters of process_packed().
+     */
+    const ccsds_frame_sync::counters_t& sync_counters() const { return d_sync.counters(); }
+
     /**
      * Get total number of successfully extracted frames.
      */
-    uint64_t frame_count() const;
+    uint64_t frame_count() const { return d_frame_count; }
+
+    /**
+     * Polarity of the last frame found.
+     */
+    ambiguity_t ambiguity() const { return d_ambiguity; }
 
 private:
     bool check_asm(uint64_t asm_buf);
     void enter_state(state_t state);
+    template <typename T>
+    int process_soft_symbols(const T* in, int ninput_items, uint8_t* out_frame, bool* frame_ready);
 
     // Config parameters
     uint64_t d_asm;
@@ -42,14 +134,22 @@ private:
     size_t   d_frame_len;
 
     // State variables
-    uint64_t d_asm_buf;
-    uint8_t  d_byte_buf;
-    uint8_t  d_bit_ctr;
-    size_t   d_frame_buffer_len;
-    uint8_t* d_frame_buffer;
-    uint64_t d_frame_count;
-    state_t d_state;
-    ambiguity_t d_ambiguity;
+    uint64_t d_asm_buf = 0;
+    uint32_t d_byte_buf = 0;
+    int      d_bit_ctr = 0;
+    size_t   d_frame_buffer_len = 0;
+    uint8_t* d_frame_buffer = nullptr;
+    uint64_t d_frame_count = 0;
+    state_t d_state = SEARCH;
+    ambiguity_t d_ambiguity = NONE;
+    ccsds_frame_sync d_sync;
+
+    // process_soft(): the ASM pattern and the last symbols searched, the
+    // first d_soft_hist of them carried over from the previous call
+    soft_sync_pattern d_soft_pattern;
+    float   d_soft_threshold;
+    int8_t* d_soft_buf = nullptr;
+    int     d_soft_hist = 0;
 };
 
 #endif // CCSDS_CORRELATOR_H
\ No newline at end of file
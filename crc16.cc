@@ -0,0 +1,180 @@
+// CRC-16-CCITT of the TM/AOS Frame Error Control Field
+//
+// Slicing-by-8: table k holds the CRC of a byte followed by k zero bytes,
+// so eight input bytes update the register with eight independent lookups.
+//
+// Carry-less multiply folding: the data is a polynomial over GF(2), first
+// bit highest, and only its remainder modulo g(x) matters. A 128-bit chunk
+// A = H x^64 + L followed by D more bits is congruent to
+// H (x^(D+64) mod g) + L (x^D mod g), two 64x16 bit carry-less products
+// that fit the width of the next chunk, so four chunks (64 bytes) in flight
+// are folded onto the next four with two PCLMULQDQ each. The final chunk
+// is reduced by the tables, which also take the initial register: it is
+// the same as adding it to the first 16 bits of the data.
+
+#include "crc16.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC16_X86 1
+#include <immintrin.h>
+#endif
+
+#define CRC16_POLY 0x1021
+
+struct crc16_tables
+{
+    uint16_t t[8][256];
+};
+
+static constexpr crc16_tables make_tables()
+{
+    crc16_tables tables = {};
+    for (int b = 0; b < 256; b++)
+    {
+        uint16_t c = b << 8;
+        for (int i = 0; i < 8; i++) c = (c & 0x8000) ? (c << 1) ^ CRC16_POLY : c << 1;
+        tables.t[0][b] = c;
+    }
+    for (int k = 1; k < 8; k++)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            const uint16_t c = tables.t[k - 1][b];
+            tables.t[k][b] = (c << 8) ^ tables.t[0][c >> 8];
+        }
+    }
+    return tables;
+}
+
+alignas(64) static constexpr crc16_tables s_tables = make_tables();
+
+static uint16_t crc16_slicing(const uint8_t* data, size_t len, uint16_t crc)
+{
+    const uint16_t (*t)[256] = s_tables.t;
+    size_t j = 0;
+    for (; j + 8 <= len; j += 8)
+    {
+        const uint8_t* d = &data[j];
+        crc = t[7][d[0] ^ (crc >> 8)] ^ t[6][d[1] ^ (crc & 0xff)] ^ t[5][d[2]] ^ t[4][d[3]] ^
+              t[3][d[4]] ^ t[2][d[5]] ^ t[1][d[6]] ^ t[0][d[7]];
+    }
+    for (; j < len; j++) crc = (crc << 8) ^ t[0][(crc >> 8) ^ data[j]];
+    return crc;
+}
+
+#ifdef CRC16_X86
+// x^n mod g(x)
+static constexpr uint64_t xpow_mod(int n)
+{
+    uint32_t r = 1;
+    for (int i = 0; i < n; i++)
+    {
+        r <<= 1;
+        if (r & 0x10000) r ^= 0x10000 | CRC16_POLY;
+    }
+    return r;
+}
+
+// folds a over the next D bits, k = {x^D mod g, x^(D+64) mod g}
+__attribute__((target("pclmul,ssse3"), always_inline))
+static inline __m128i fold(__m128i a, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x00), _mm_clmulepi64_si128(a, k, 0x11));
+}
+
+// 16 bytes as a 128-bit polynomial, the first byte in the top bits
+__attribute__((target("pclmul,ssse3"), always_inline))
+static inline __m128i load_be(const uint8_t* p, __m128i reverse)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), reverse);
+}
+
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_pclmul(const uint8_t* data, size_t len, uint16_t crc)
+{
+    if (len < 64) return crc16_slicing(data, len, crc);
+
+    const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i k512 = _mm_set_epi64x(xpow_mod(512 + 64), xpow_mod(512));
+    const __m128i k128 = _mm_set_epi64x(xpow_mod(128 + 64), xpow_mod(128));
+
+    __m128i a0 = _mm_xor_si128(load_be(data, reverse), _mm_set_epi64x((uint64_t)crc << 48, 0));
+    __m128i a1 = load_be(&data[16], reverse);
+    __m128i a2 = load_be(&data[32], reverse);
+    __m128i a3 = load_be(&data[48], reverse);
+    size_t j = 64;
+    for (; j + 64 <= len; j += 64)
+    {
+        a0 = _mm_xor_si128(fold(a0, k512), load_be(&data[j], reverse));
+        a1 = _mm_xor_si128(fold(a1, k512), load_be(&data[j + 16], reverse));
+        a2 = _mm_xor_si128(fold(a2, k512), load_be(&data[j + 32], reverse));
+        a3 = _mm_xor_si128(fold(a3, k512), load_be(&data[j + 48], reverse));
+    }
+
+    __m128i a = _mm_xor_si128(fold(a0, k128), a1);
+    a = _mm_xor_si128(fold(a, k128), a2);
+    a = _mm_xor_si128(fold(a, k128), a3);
+    for (; j + 16 <= len; j += 16)
+    {
+        a = _mm_xor_si128(fold(a, k128), load_be(&data[j], reverse));
+    }
+
+    uint8_t rest[16];
+    _mm_storeu_si128((__m128i*)rest, _mm_shuffle_epi8(a, reverse));
+    crc = crc16_slicing(rest, 16, 0);
+    return crc16_slicing(&data[j], len - j, crc);
+}
+#endif
+
+typedef uint16_t (*crc16_fn)(const uint8_t*, size_t, uint16_t);
+
+struct crc16_kernel_t
+{
+    const char* name;
+    crc16_fn fn;
+};
+
+static const crc16_kernel_t* select_kernel()
+{
+    static const crc16_kernel_t generic = {"slicing-by-8", crc16_slicing};
+#ifdef CRC16_X86
+    static const crc16_kernel_t pclmul = {"pclmul", crc16_pclmul};
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3"))
+    {
+        return &pclmul;
+    }
+#endif
+    return &generic;
+}
+
+static const crc16_kernel_t& kernel()
+{
+    static const crc16_kernel_t* k = select_kernel();
+    return *k;
+}
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t len, uint16_t crc)
+{
+    return kernel().fn(data, len, crc);
+}
+
+void fecf_append(uint8_t* frame, size_t len)
+{
+    const uint16_t crc = crc16_ccitt(frame, len - FECF_LEN);
+    frame[len - 2] = crc >> 8;
+    frame[len - 1] = crc & 0xff;
+}
+
+bool fecf_check(const uint8_t* frame, size_t len)
+{
+    return crc16_ccitt(frame, len) == 0;
+}
+
+const char* crc16_kernel()
+{
+    return kernel().name;
+}
@@ -0,0 +1,39 @@
+#ifndef INCLUDED_CRC16_H
+#define INCLUDED_CRC16_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// the Frame Error Control Field closing a TM/AOS transfer frame
+#define FECF_LEN 2
+
+/**
+ * CRC-16-CCITT as used for the FECF: g(x) = x^16 + x^12 + x^5 + 1, MSB
+ * first, no final XOR. Pass the result of a previous call as crc to
+ * continue over more data. Long buffers are folded 64 bytes at a time with
+ * carry-less multiplies (PCLMULQDQ), short ones and the remainder go
+ * through slicing-by-8 tables; the kernel is chosen once at runtime from
+ * the CPU features.
+ *
+ * @param crc Register before the first byte, all ones for the FECF
+ */
+uint16_t crc16_ccitt(const uint8_t* data, size_t len, uint16_t crc = 0xffff);
+
+/**
+ * Writes the FECF of the first len - FECF_LEN bytes of frame to its last
+ * FECF_LEN bytes, MSB first.
+ */
+void fecf_append(uint8_t* frame, size_t len);
+
+/**
+ * @return true if the last FECF_LEN bytes of the frame of len bytes are
+ *         the FECF of the ones before (the CRC over the whole frame is 0)
+ */
+bool fecf_check(const uint8_t* frame, size_t len);
+
+/**
+ * @return Name of the CRC kernel selected for this CPU
+ */
+const char* crc16_kernel();
+
+#endif /* INCLUDED_CRC16_H */
@@ -0,0 +1,54 @@
+#include "frame_ring.h"
+
+#include <stdlib.h>
+
+frame_ring::frame_ring(size_t n_slots, size_t slot_size)
+    : d_n_slots(n_slots), d_slot_size(slot_size), d_stride((slot_size + 63) & ~(size_t)63)
+{
+    d_slots = (uint8_t*) aligned_alloc(64, d_n_slots * d_stride);
+    d_len = (size_t*) calloc(d_n_slots, sizeof(size_t));
+    d_flags = (uint32_t*) calloc(d_n_slots, sizeof(uint32_t));
+}
+
+frame_ring::~frame_ring()
+{
+    free(d_slots);
+    free(d_len);
+    free(d_flags);
+}
+
+uint8_t* frame_ring::begin_write()
+{
+    const uint64_t head = d_head.load(std::memory_order_relaxed);
+    if (head - d_tail.load(std::memory_order_acquire) == d_n_slots)
+    {
+        d_overflows.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return slot(head);
+}
+
+void frame_ring::end_write(size_t len, uint32_t flags)
+{
+    const uint64_t head = d_head.load(std::memory_order_relaxed);
+    d_len[head % d_n_slots] = len;
+    d_flags[head % d_n_slots] = flags;
+    d_head.store(head + 1, std::memory_order_release);
+}
+
+bool frame_ring::read(frame_view* view) const
+{
+    const uint64_t tail = d_tail.load(std::memory_order_relaxed);
+    if (tail == d_head.load(std::memory_order_acquire)) return false;
+
+    view->data = slot(tail);
+    view->len = d_len[tail % d_n_slots];
+    view->flags = d_flags[tail % d_n_slots];
+    view->seq = tail;
+    return true;
+}
+
+void frame_ring::release()
+{
+    d_tail.store(d_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
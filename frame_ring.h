@@ -0,0 +1,81 @@
+#ifndef INCLUDED_FRAME_RING_H
+#define INCLUDED_FRAME_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// frame_view flags
+#define FRAME_FLYWHEEL 0x1  // delivered by the synchronizer without its ASM
+
+// a published frame, read-only, valid until frame_ring::release()
+struct frame_view
+{
+    const uint8_t* data;
+    size_t len;
+    uint32_t flags;
+    uint64_t seq;  // publication number
+};
+
+/**
+ * Ring of fixed size frame slots between one producer and one consumer
+ * (which may be different threads). The producer writes a frame straight
+ * into the next free slot and publishes it, the consumer reads the oldest
+ * published frame in place and releases its slot when done, so a frame is
+ * never copied between the stages. Slots are 64-byte aligned.
+ */
+class frame_ring
+{
+public:
+    frame_ring(size_t n_slots, size_t slot_size);
+    ~frame_ring();
+
+    frame_ring(const frame_ring&) = delete;
+    frame_ring& operator=(const frame_ring&) = delete;
+
+    /**
+     * Producer: the next free slot, slot_size() bytes, or nullptr if all
+     * slots hold unreleased frames (counted in overflows()). Calling it
+     * again before end_write() returns the same slot.
+     */
+    uint8_t* begin_write();
+
+    /**
+     * Producer: publishes the frame written to the slot of begin_write().
+     */
+    void end_write(size_t len, uint32_t flags = 0);
+
+    /**
+     * Consumer: the oldest published frame.
+     *
+     * @return False if there is none
+     */
+    bool read(frame_view* view) const;
+
+    /**
+     * Consumer: frees the slot of the frame returned by read().
+     */
+    void release();
+
+    size_t n_slots() const { return d_n_slots; }
+    size_t slot_size() const { return d_slot_size; }
+    size_t count() const { return d_head.load(std::memory_order_acquire) - d_tail.load(std::memory_order_acquire); }
+    uint64_t overflows() const { return d_overflows.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t* slot(uint64_t n) const { return d_slots + (n % d_n_slots) * d_stride; }
+
+    size_t   d_n_slots;
+    size_t   d_slot_size;
+    size_t   d_stride;
+    uint8_t* d_slots = nullptr;
+    size_t*   d_len = nullptr;
+    uint32_t* d_flags = nullptr;
+    std::atomic<uint64_t> d_overflows{0};
+
+    // frames published and released, on separate cache lines
+    alignas(64) std::atomic<uint64_t> d_head{0};
+    alignas(64) std::atomic<uint64_t> d_tail{0};
+};
+
+#endif /* INCLUDED_FRAME_RING_H */
@@ -0,0 +1,252 @@
+#include "frame_sync.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// shifts up to count bits of the stream from bit pos on into the window,
+// 56 at a time, returns the bit following the last one shifted
+static size_t shift_bits(const uint8_t* in, size_t n_bytes, size_t pos, int count, sync_window* window)
+{
+    const size_t n_bits = n_bytes * 8;
+    while (count > 0 && pos < n_bits)
+    {
+        int c = count < 56 ? count : 56;
+        if ((size_t)c > n_bits - pos) c = n_bits - pos;
+
+        uint64_t v;
+        if ((pos >> 3) + 8 <= n_bytes)
+        {
+            v = (load_be64(&in[pos >> 3]) << (pos & 7)) >> (64 - c);
+        }
+        else
+        {
+            v = 0;
+            for (int i = 0; i < c; i++) v = (v << 1) | get_bit(in, pos + i);
+        }
+
+        window->bits_hi = (window->bits_hi << c) | (window->bits >> (64 - c));
+        window->bits = (window->bits << c) | v;
+        window->n_valid = window->n_valid + c < 128 ? window->n_valid + c : 128;
+        pos += c;
+        count -= c;
+    }
+    return pos;
+}
+
+ccsds_frame_sync::ccsds_frame_sync(uint64_t sync_word, uint64_t mask, int threshold, size_t frame_len,
+                                   bool match_inverted, int verify_count, int flywheel_count)
+    : d_sync_word(sync_word), d_mask(mask), d_sync_len(64 - __builtin_clzll(mask)),
+      d_mask_bits(__builtin_popcountll(mask)), d_threshold(threshold), d_frame_len(frame_len),
+      d_match_inverted(match_inverted), d_verify_count(verify_count), d_flywheel_count(flywheel_count)
+{
+    d_frame_buffer = (uint8_t*) malloc(frame_len);
+    reset();
+}
+
+ccsds_frame_sync::~ccsds_frame_sync()
+{
+    free(d_frame_buffer);
+}
+
+void ccsds_frame_sync::reset()
+{
+    d_window = {0, 0, 0};
+    d_in_frame = false;
+    d_inverted = false;
+    enter_state(SEARCH);
+}
+
+int ccsds_frame_sync::process(const uint8_t* in, size_t n_bytes, const frame_callback_t& on_frame)
+{
+    d_ring = nullptr;
+    return run(in, n_bytes, &on_frame, nullptr);
+}
+
+int ccsds_frame_sync::process(const uint8_t* in, size_t n_bytes, frame_ring* ring, const frame_filter_t& filter)
+{
+    d_ring = ring;
+    return run(in, n_bytes, nullptr, &filter);
+}
+
+int ccsds_frame_sync::run(const uint8_t* in, size_t n_bytes, const frame_callback_t* on_frame,
+                          const frame_filter_t* filter)
+{
+    const size_t n_bits = n_bytes * 8;
+    size_t pos = 0;
+    int n_frames = 0;
+    while (pos < n_bits)
+    {
+        if (!d_in_frame && d_state == SEARCH)
+        {
+            bool inverted = false;
+            if (find_sync_word_masked(in, n_bytes, &pos, d_sync_word, d_mask, d_threshold, d_match_inverted,
+                                      &d_window, &inverted))
+            {
+                d_inverted = inverted;
+                d_frame_state = SEARCH;
+                enter_state(d_verify_count > 0 ? CHECK : LOCK);
+                enter_frame(0, 0);
+            }
+            continue;
+        }
+
+        if (!d_in_frame)
+        {
+            // one bit past the expected end of the ASM
+            pos = shift_bits(in, n_bytes, pos, d_sync_len + 2 - d_window.n_valid, &d_window);
+            if (d_window.n_valid < d_sync_len + 2) break;
+            check_boundary(&pos);
+            continue;
+        }
+
+        if (on_frame && d_frame_buffer_len == 0 && d_bit_ctr == 0 && pos % 8 == 0 && !d_inverted &&
+            n_bits - pos >= d_frame_len * 8)
+        {
+            // the whole frame is in the input buffer
+            (*on_frame)(&in[pos / 8], d_frame_len);
+            pos += d_frame_len * 8;
+            n_frames++;
+        }
+        else
+        {
+            pos = append_bits(in, n_bits, pos, d_frame_dst, &d_frame_buffer_len, d_frame_len, &d_byte_buf,
+                              &d_bit_ctr);
+            if (d_frame_buffer_len < d_frame_len) break;
+
+            if (d_inverted)
+            {
+                for (size_t i = 0; i < d_frame_len; i++) d_frame_dst[i] ^= 0xff;
+            }
+            if (on_frame)
+            {
+                (*on_frame)(d_frame_dst, d_frame_len);
+                n_frames++;
+            }
+            else if (d_frame_dst != d_frame_buffer)
+            {
+                size_t len = d_frame_len;
+                if (!*filter || (*filter)(d_frame_dst, &len))
+                {
+                    d_ring->end_write(len, d_frame_state == FLYWHEEL ? FRAME_FLYWHEEL : 0);
+                    n_frames++;
+                }
+            }
+        }
+        d_counters.frames[d_frame_state]++;
+
+        // the next ASM is checked from the last bit of this frame on, see check_boundary()
+        d_window = {(uint64_t)get_bit(in, pos - 1), 0, 1};
+        d_in_frame = false;
+    }
+    return n_frames;
+}
+
+bool ccsds_frame_sync::check_asm(uint64_t bits, bool inverted) const
+{
+    const int wrong_bits = __builtin_popcountll((bits ^ d_sync_word) & d_mask);
+    return (inverted ? d_mask_bits - wrong_bits : wrong_bits) <= d_threshold;
+}
+
+// The window holds the last bit of the previous frame, the expected ASM and
+// the first bit after it. The ASM is tested on time, one bit early and one
+// bit late; the return value is the number of bits of the next frame already
+// in the window, -1 if there's no ASM.
+int ccsds_frame_sync::find_boundary_asm(bool inverted) const
+{
+    const uint64_t late = d_window.bits;
+    const uint64_t on_time = (d_window.bits >> 1) | (d_window.bits_hi << 63);
+    const uint64_t early = (d_window.bits >> 2) | (d_window.bits_hi << 62);
+
+    if (check_asm(on_time, inverted)) return 1;
+    if (check_asm(early, inverted)) return 2;
+    if (check_asm(late, inverted)) return 0;
+    return -1;
+}
+
+void ccsds_frame_sync::check_boundary(size_t* pos)
+{
+    int n_frame_bits = find_boundary_asm(d_inverted);
+    if (n_frame_bits >= 0)
+    {
+        if (n_frame_bits != 1) d_counters.slips++;
+        d_frame_state = d_state == CHECK ? CHECK : LOCK;
+        if (d_state == FLYWHEEL || (d_state == CHECK && ++d_verified >= d_verify_count))
+        {
+            enter_state(LOCK);
+        }
+        enter_boundary_frame(n_frame_bits, pos);
+        return;
+    }
+    d_counters.misses++;
+
+    // the search would find an ASM of the other polarity here
+    n_frame_bits = d_match_inverted ? find_boundary_asm(!d_inverted) : -1;
+    if (n_frame_bits >= 0)
+    {
+        d_inverted = !d_inverted;
+        d_frame_state = SEARCH;
+        enter_state(d_verify_count > 0 ? CHECK : LOCK);
+        enter_boundary_frame(n_frame_bits, pos);
+        return;
+    }
+
+    if ((d_state == LOCK && d_flywheel_count > 0) || (d_state == FLYWHEEL && d_missed < d_flywheel_count))
+    {
+        if (d_state == LOCK) enter_state(FLYWHEEL);
+        d_missed++;
+        d_frame_state = FLYWHEEL;
+        enter_boundary_frame(1, pos);
+        return;
+    }
+
+    // the search goes on with the bits in the window
+    enter_state(SEARCH);
+}
+
+// Starts the frame whose first n_frame_bits bits are the last ones of the
+// window. If they're in the input buffer pos is moved back to them instead,
+// so that an aligned frame can be delivered in place.
+void ccsds_frame_sync::enter_boundary_frame(int n_frame_bits, size_t* pos)
+{
+    if ((size_t)n_frame_bits <= *pos)
+    {
+        *pos -= n_frame_bits;
+        enter_frame(0, 0);
+    }
+    else
+    {
+        enter_frame(d_window.bits & ((1u << n_frame_bits) - 1), n_frame_bits);
+    }
+}
+
+void ccsds_frame_sync::enter_frame(uint32_t bits, int n_bits)
+{
+    // frames that don't fit in the ring are assembled in d_frame_buffer and dropped
+    d_frame_dst = d_ring ? d_ring->begin_write() : nullptr;
+    if (!d_frame_dst) d_frame_dst = d_frame_buffer;
+    d_in_frame = true;
+    d_frame_buffer_len = 0;
+    d_byte_buf = bits;
+    d_bit_ctr = n_bits;
+}
+
+void ccsds_frame_sync::enter_state(state_t state)
+{
+    switch (state)
+    {
+        case CHECK:
+        {
+            d_verified = 0;
+            break;
+        }
+        case FLYWHEEL:
+        {
+            d_missed = 0;
+            break;
+        }
+        default:
+            break;
+    }
+    d_counters.entered[state]++;
+    d_state = state;
+}
@@ -0,0 +1,139 @@
+#ifndef INCLUDED_FRAME_SYNC_H
+#define INCLUDED_FRAME_SYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "bitstream.h"
+#include "frame_ring.h"
+
+/**
+ * Frame synchronizer for a packed bitstream (8 bits per byte, MSB first) of
+ * ASM + fixed length frames, as in CCSDS 131.0-B:
+ *
+ *   SEARCH    the ASM is searched at every bit offset (find_sync_word_masked())
+ *   CHECK     the ASM is only tested where the next frame should start, each
+ *             of verify_count matches brings the synchronizer closer to LOCK,
+ *             a miss back to SEARCH
+ *   LOCK      ASM tested at the expected frame boundary only, a miss leads
+ *             to FLYWHEEL (or SEARCH if flywheel_count is 0)
+ *   FLYWHEEL  frames are still delivered at the expected boundary for up to
+ *             flywheel_count missing ASMs in a row, a match returns to LOCK
+ *
+ * At the expected boundary the ASM is also tested one bit early and one bit
+ * late, so that a slipped bit doesn't cost the lock. Frames are delivered
+ * in every state; a miss in CHECK, or past the flywheel, drops the frame and
+ * goes back to SEARCH. Frames are either passed to a callback (a byte
+ * aligned, non-inverted frame wholly in the input buffer in place) or
+ * assembled straight into the slots of a frame_ring.
+ */
+class ccsds_frame_sync
+{
+public:
+    enum state_t { SEARCH, CHECK, LOCK, FLYWHEEL, NSTATES };
+
+    // receives each frame, valid during the call only
+    typedef std::function<void(const uint8_t* frame, size_t frame_len)> frame_callback_t;
+
+    // works on a complete frame in its ring slot before it's published, may
+    // change its length, returns false to drop it
+    typedef std::function<bool(uint8_t* frame, size_t* frame_len)> frame_filter_t;
+
+    struct counters_t
+    {
+        uint64_t entered[NSTATES];  // transitions into each state
+        uint64_t frames[NSTATES];   // frames delivered: acquired by SEARCH, verified in CHECK,
+                                    // matched in LOCK, or FLYWHEEL without their ASM
+        uint64_t slips;             // ASMs found one bit early or late
+        uint64_t misses;            // ASMs missing at the expected boundary
+    };
+
+    /**
+     * @param sync_word      ASM, up to 64 bits
+     * @param mask           Bits of sync_word compared (non-zero)
+     * @param threshold      Maximum number of differing ASM bits
+     * @param frame_len      Bytes between an ASM and the next
+     * @param match_inverted Also acquire the complement of the ASM (BPSK
+     *                       phase ambiguity), whose frames are inverted back
+     * @param verify_count   ASMs to confirm in CHECK before LOCK, 0 to lock
+     *                       on the first one
+     * @param flywheel_count Missing ASMs tolerated in a row once locked
+     */
+    ccsds_frame_sync(uint64_t sync_word, uint64_t mask, int threshold, size_t frame_len, bool match_inverted,
+                     int verify_count = 0, int flywheel_count = 0);
+    ~ccsds_frame_sync();
+
+    ccsds_frame_sync(const ccsds_frame_sync&) = delete;
+    ccsds_frame_sync& operator=(const ccsds_frame_sync&) = delete;
+
+    /**
+     * Synchronizes to the next n_bytes of the stream and passes every
+     * complete frame to on_frame. Frames and ASMs may span calls.
+     *
+     * @return Number of frames delivered
+     */
+    int process(const uint8_t* in, size_t n_bytes, const frame_callback_t& on_frame);
+
+    /**
+     * Same as above, every frame is assembled in the next free slot of ring
+     * (slot_size() >= frame_len), passed to filter if there is one and
+     * published. Frames found while the ring is full are dropped (counted
+     * in frame_ring::overflows()). Don't mix with the callback version.
+     *
+     * @return Number of frames published
+     */
+    int process(const uint8_t* in, size_t n_bytes, frame_ring* ring, const frame_filter_t& filter = nullptr);
+
+    void set_verify_count(int verify_count) { d_verify_count = verify_count; }
+    void set_flywheel_count(int flywheel_count) { d_flywheel_count = flywheel_count; }
+
+    /**
+     * Back to SEARCH, the counters are kept.
+     */
+    void reset();
+
+    state_t state() const { return d_state; }
+    bool inverted() const { return d_inverted; }
+    const counters_t& counters() const { return d_counters; }
+    void reset_counters() { d_counters = {}; }
+
+private:
+    int run(const uint8_t* in, size_t n_bytes, const frame_callback_t* on_frame, const frame_filter_t* filter);
+    void enter_state(state_t state);
+    void enter_frame(uint32_t bits, int n_bits);
+    void enter_boundary_frame(int n_frame_bits, size_t* pos);
+    bool check_asm(uint64_t bits, bool inverted) const;
+    int find_boundary_asm(bool inverted) const;
+    void check_boundary(size_t* pos);
+
+    // Config parameters
+    uint64_t d_sync_word;
+    uint64_t d_mask;
+    int      d_sync_len;
+    int      d_mask_bits;
+    int      d_threshold;
+    size_t   d_frame_len;
+    bool     d_match_inverted;
+    int      d_verify_count;
+    int      d_flywheel_count;
+
+    // State variables
+    state_t  d_state = SEARCH;
+    bool     d_inverted = false;
+    bool     d_in_frame = false;  // assembling a frame, otherwise looking for its ASM
+    int      d_verified = 0;
+    int      d_missed = 0;
+    state_t  d_frame_state = SEARCH;  // state that accepted the frame being assembled
+    // SEARCH: the search window; other states: the last bit of the previous
+    // frame and the bits after it, up to one past the expected ASM
+    sync_window d_window = {0, 0, 0};
+    uint32_t d_byte_buf = 0;
+    int      d_bit_ctr = 0;
+    size_t   d_frame_buffer_len = 0;
+    uint8_t* d_frame_buffer = nullptr;
+    frame_ring* d_ring = nullptr;      // of the current process() call
+    uint8_t* d_frame_dst = nullptr;    // ring slot of the frame, or d_frame_buffer
+    counters_t d_counters = {};
+};
+
+#endif /* INCLUDED_FRAME_SYNC_H */
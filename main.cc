@@ -8,11 +8,17 @@
 #include <sstream>
 #include <string>
 #include <cmath>
+#include <vector>
+#include <bitset>
+#include <algorithm>
 
 #include "ccsds_rs_encoder.h"
 #include "ccsds_rs_decoder.h"
+#include "reed_solomon.h"
+#include "bitstream.h"
 #include "ccsds.h"
 #include "viterbi27.h"
+#include "crc16.h"
 
 #include <cctype>
 
@@ -127,6 +133,12 @@ int main(int argc, char* argv[])
     bool verbose       = false;
     int  n_interleave  = 8;
     bool dual_basis    = true;
+    bool erasures      = false;
+    int  max_erasures  = -1;   // default: half the parity symbols of the code
+    rs_code_t rs_code  = RS_CODE_255_223;
+    int  virtual_fill  = 0;     // shortened RS codewords
+    randomizer_t randomizer_type = RANDOMIZER_CCSDS;
+    bool fecf          = false; // CRC-16 frame error control field
     ccsds_mode_t mode  = RS_AND_CC;
 
     // Use command-line argument for config file name if provided.
@@ -170,6 +182,28 @@ int main(int argc, char* argv[])
           else if (key == "verbose")         verbose      = parse_bool(value, verbose);
           else if (key == "n_interleave")    n_interleave = std::max(1, stoi(value));
           else if (key == "dual_basis")      dual_basis   = parse_bool(value, dual_basis);
+          else if (key == "erasures")        erasures     = parse_bool(value, erasures);
+          else if (key == "max_erasures")    max_erasures = stoi(value);
+          else if (key == "virtual_fill")    virtual_fill = std::max(0, stoi(value));
+          else if (key == "fecf")            fecf         = parse_bool(value, fecf);
+          else if (key == "rs_code")
+          {
+            if (!rs_code_from_string(value.c_str(), &rs_code))
+            {
+                std::cerr << "[WARN] Unknown rs_code '" << value
+                          << "'. Using 255,223.\n";
+                rs_code = RS_CODE_255_223;
+            }
+          }
+          else if (key == "randomizer")
+          {
+            if (!randomizer_from_string(value.c_str(), &randomizer_type))
+            {
+                std::cerr << "[WARN] Unknown randomizer '" << value
+                          << "'. Using ccsds.\n";
+                randomizer_type = RANDOMIZER_CCSDS;
+            }
+          }
           else if (key == "mode")
           {
             std::string m = lower(value);
@@ -187,6 +221,11 @@ int main(int argc, char* argv[])
     }
     config.close();
 
+    reed_solomon rs_params(rs_code, virtual_fill);
+    if (max_erasures < 0)
+    {
+        max_erasures = rs_params.parity_len() / 2;
+    }
 
 
     // Replace '/' with '_' in puncturing_type.
@@ -213,7 +252,28 @@ int main(int argc, char* argv[])
       case RS_AND_CC: oss << "RS_AND_CC"; break;
     }
 
-    oss << "_intlv" << n_interleave << (dual_basis ? "_dualBasis" : "_noDualBasis") << ".txt";
+    oss << "_intlv" << n_interleave << (dual_basis ? "_dualBasis" : "_noDualBasis");
+    if (rs_code != RS_CODE_255_223)
+    {
+        oss << "_rs" << rs_params.block_len() << "_" << rs_params.data_len();
+    }
+    if (virtual_fill > 0)
+    {
+        oss << "_fill" << rs_params.virtual_fill();
+    }
+    if (scramble_val && randomizer_type == RANDOMIZER_HIGH_RATE)
+    {
+        oss << "_highRateRand";
+    }
+    if (fecf)
+    {
+        oss << "_fecf";
+    }
+    if (erasures && mode != ONLY_CC)
+    {
+        oss << "_erasures" << max_erasures;
+    }
+    oss << ".txt";
 
     output_filename = oss.str();
 
@@ -309,37 +369,43 @@ int main(int argc, char* argv[])
 
     srand(time(nullptr));
     // RS Encode
-    ccsds_rs_encoder encoder(rs_encode, interleave, scramble_val, printing, verbose, n_interleave, dual_basis);
+    const randomizer& scrambler = randomizer::get(randomizer_type);
+    ccsds_rs_encoder encoder(rs_encode, interleave, scramble_val, printing, verbose, n_interleave, dual_basis, rs_code, virtual_fill, &scrambler);
     // RS Decode
-    ccsds_rs_decoder decoder(0, rs_encode, interleave, scramble_val, verbose, printing, n_interleave, dual_basis);
+    ccsds_rs_decoder decoder(0, rs_encode, interleave, scramble_val, verbose, printing, n_interleave, dual_basis, rs_code, virtual_fill, &scrambler);
+    decoder.set_max_erasures(max_erasures);
+    encoder.set_fecf(fecf);
+    decoder.set_fecf(fecf);
 
-    int payload_len = RS_DATA_LEN * n_interleave;
+    int payload_len = encoder.data_len();
 
-    const int frame_len = SYNC_WORD_LEN + RS_BLOCK_LEN * n_interleave;
+    const int frame_len = encoder.total_frame_len();
     if (mode == ONLY_CC)
     {
        payload_len = frame_len; // For ONLY_CC, payload is the same as frame length
     }
     uint8_t input_payload[payload_len];
-    // add one since convolutional encoder not decodes the last byte make it always 0
-    // 3 zeros at the end  and 5 at the beginning
-    uint8_t encoded_frame[frame_len + 8];
+    // one more byte for the zero tail that terminates the convolutional code
+    uint8_t encoded_frame[frame_len + 1];
     uint8_t decoded_output[payload_len];
 
     //cout << "Payload length: " << payload_len << " bytes" << endl;
     //cout << "Frame length: " << frame_len << " bytes" << endl;
     //cout << "Encoded frame length: " << frame_len + 1 << " bytes (+1 for CC padding)" << endl;
 
-    // add one since convolutional encoder not decodes the last 3 bytes make it always 0
-    // 3 zeros at the end and 5 at the beginning
-    unsigned int conv_len = (frame_len + 8) * 16; // 8 bits per byte * 2 bits per input bit for convolutional encoding
+    // each frame is convolutionally encoded from state 0 and terminated by
+    // a zero tail byte, so it is decoded as one block
+    unsigned int conv_len = (frame_len + 1) * 16; // 8 bits per byte * 2 bits per input bit for convolutional encoding
 
     //cout << "Convolutional encoded length (conv_len): " << conv_len << " bits" << endl;
 
     // Convolutional decode initialization
-    v27 vi;
-    memset(&vi, 0, sizeof(v27));
-    vitfilt27_init(&vi);
+    v27_block vb;
+    if (vitfilt27_block_init(&vb, (frame_len + 1) * 8) != 0)
+    {
+        std::cerr << "Error: Could not allocate the Viterbi decisions\n";
+        return 1;
+    }
 
     // Generate SNR values from config (in dB)
     vector<double> EbN0_values;
@@ -354,6 +420,8 @@ int main(int argc, char* argv[])
         double EbN0 = pow(10.0, EbN0_values[i] / 10.0);
         unsigned long total_errors = 0;
         unsigned long total_bits = 0;
+        unsigned long total_frames = 0;
+        unsigned long delivered_frames = 0;  // frames that passed their FECF
 
         unsigned long nbits = (num_bits * pow(2.0, EbN0_values[i] / 2.0));
         //unsigned long nbits = (num_bits * 100);
@@ -367,7 +435,7 @@ int main(int argc, char* argv[])
         double EbN0 = pow(10.0,  EbN0_values[i] / 10.0);
         double N0 = 0.0;
         // code rate for RS
-        double code_rate_rs = static_cast<double>(RS_DATA_LEN) / static_cast<double>(RS_BLOCK_LEN);
+        double code_rate_rs = static_cast<double>(rs_params.data_len()) / static_cast<double>(rs_params.block_len());
         switch (mode)
         {
           case ONLY_RS:
@@ -394,12 +462,7 @@ int main(int argc, char* argv[])
             {
                 input_payload[i] = rand() % 256;
             }
-            // make 3 byte  always 0 and 5 bytes at the beginning
-            encoded_len = encoder.encode(input_payload, encoded_frame) + 8;
-            // here is the last byte always 0
-            encoded_frame[encoded_len - 1] = 0;
-            encoded_frame[encoded_len - 2] = 0;
-            encoded_frame[encoded_len - 3] = 0;
+            encoded_len = encoder.encode(input_payload, encoded_frame);
 
 
 
@@ -418,18 +481,11 @@ int main(int argc, char* argv[])
             {
                 encoded_frame[i] = rand() % 256;
             }
-            encoded_len = frame_len + 8;
-            // make 3 byte  always 0 and 5 bytes at the beginning
-            encoded_frame[encoded_len - 1] = 0;
-            encoded_frame[encoded_len - 2] = 0;
-            encoded_frame[encoded_len - 3] = 0;
-
-            // Add 5 zeros at the beginning
-            encoded_frame[0] = 0;
-            encoded_frame[1] = 0;
-            encoded_frame[2] = 0;
-            encoded_frame[3] = 0;
-            encoded_frame[4] = 0;
+            encoded_len = frame_len;
+            if (fecf)
+            {
+                fecf_append(encoded_frame, frame_len);
+            }
 
             if (0)
             {
@@ -446,10 +502,11 @@ int main(int argc, char* argv[])
           // Convolutional encode
           // TODO: here check the size of conv_encoded
           // encode produces 2 bits for every input bit. therefore, 8 bits pro byte * 2 bits = 16 times the size of the input
-          // 5 bytes at the beginning and 3 (totally 8) at the end are always 0
-          unsigned char conv_encoded[(frame_len + 8) * 16];
+          // the zero tail byte brings the encoder back to state 0
+          unsigned char conv_encoded[(frame_len + 1) * 16];
           unsigned char state = 0;
-          unsigned int conv_len_real = encode27(&state, conv_encoded, encoded_frame, encoded_len,
+          encoded_frame[encoded_len] = 0;
+          unsigned int conv_len_real = encode27(&state, conv_encoded, encoded_frame, encoded_len + 1,
                                           puncture_C1_ptr, puncture_C2_ptr, puncture_pattern_len);
 
           //cout << "Convolutional encoded length (conv_len_real): " << conv_len_real << " bits" << endl;
@@ -519,7 +576,7 @@ int main(int argc, char* argv[])
 
 
 
-          unsigned char conv_decoded[frame_len + 16]; // +16 for traceback bias
+          unsigned char conv_decoded[frame_len + 1]; // frame and tail byte
 
           //
           //cout << "5.5" << endl;
@@ -528,19 +585,12 @@ int main(int argc, char* argv[])
           //cout << "conv_decoded size = " << sizeof(conv_decoded) << endl;
           //
 
-          vitfilt27_decode(&vi, soft, conv_decoded, conv_len + 256);
-
-          // first 5 bytes at thhe beginning are set always to 0
-          conv_decoded[0 + 16] = 0;
-          conv_decoded[1 + 16] = 0;
-          conv_decoded[2 + 16] = 0;
-          conv_decoded[3 + 16] = 0;
-          conv_decoded[4 + 16] = 0;
+          vitfilt27_decode_block(&vb, soft, conv_decoded, conv_len / 2, 0);
 
           if (0)
           {
               //std::cout << "\n--- conv_decoded ---\n";
-              //print_bytes(conv_decoded, frame_len + 16);
+              //print_bytes(conv_decoded, frame_len);
 
               // Compare original encoded_frame and conv_decoded
               // std::cout << "\n--- Comparing conv_decoded with encoded_frame ---\n";
@@ -550,7 +600,7 @@ int main(int argc, char* argv[])
               for (int i = 0; i < frame_len; ++i)
               {
                   uint8_t original = encoded_frame[i];
-                  uint8_t decoded  = conv_decoded[i + 16];  // skip traceback bias
+                  uint8_t decoded  = conv_decoded[i];
                   uint8_t diff = original ^ decoded;
 
                 if (diff != 0)
@@ -571,18 +621,36 @@ int main(int argc, char* argv[])
             // std::cout << "\nBit error count: " << bit_errors << " / " << bit_count << "  => BER = " << (double)bit_errors / bit_count << "\n";
           }
 
-          if (mode == RS_AND_CC)
+          if (mode == RS_AND_CC && erasures)
           {
-            decoder.decode_aligned_bytes(&conv_decoded[16], frame_len, decoded_output, &noutput_items);
+            // byte reliability: weakest bit of the byte, measured on the
+            // soft symbols the Viterbi decoder was fed with
+            uint8_t reliability[frame_len];
+            for (int i = 0; i < frame_len; ++i)
+            {
+                int rel = 255;
+                for (int b = 0; b < 8; ++b)
+                {
+                    int s0 = soft[16 * i + 2 * b];
+                    int s1 = soft[16 * i + 2 * b + 1];
+                    rel = std::min(rel, std::abs(s0 - 128) + std::abs(s1 - 128));
+                }
+                reliability[i] = rel;
+            }
+            decoder.decode_aligned_bytes(conv_decoded, reliability, frame_len, decoded_output, &noutput_items);
+          }
+          else if (mode == RS_AND_CC)
+          {
+            decoder.decode_aligned_bytes(conv_decoded, frame_len, decoded_output, &noutput_items);
           }
           else
           {
             // mode == ONLY_CC
             for (int i = 0; i < frame_len; ++i)
             {
-                decoded_output[i] = conv_decoded[16 + i]; // skip traceback bias
+                decoded_output[i] = conv_decoded[i];
             }
-            noutput_items = frame_len;
+            noutput_items = (!fecf || fecf_check(decoded_output, frame_len)) ? frame_len : 0;
 
             if (0)
             {
@@ -595,7 +663,7 @@ int main(int argc, char* argv[])
         {
           // RS Decode only mode == ONLY_RS
           // Convert to bitstream for decoder
-          uint8_t bitstream[frame_len * 8];
+          uint8_t bitstream[encoded_len * 8];
           for (int i = 0; i < encoded_len; ++i)
           {
             for (int j = 0; j < 8; ++j)
@@ -624,9 +692,14 @@ int main(int argc, char* argv[])
               bitstream[i] = received[i] >= 0.0 ? 0 : 1;
           }
 
-          decoder.find_asm_and_decode(bitstream, encoded_len * 8, decoded_output, &noutput_items);
+          uint8_t packed[encoded_len];
+          pack_bits(bitstream, encoded_len * 8, packed);
+          decoder.find_asm_and_decode_packed(packed, encoded_len, decoded_output, &noutput_items);
         }
         
+        total_frames++;
+        if (noutput_items > 0) delivered_frames++;
+
         // Validate
         bool match = false;
         if (mode == ONLY_CC)
@@ -687,10 +760,22 @@ int main(int argc, char* argv[])
       }
       double ber = (double)total_errors / total_bits;
       cout << fixed << setprecision(2) << "Eb/N0 (dB) = " << EbN0_values[i] << ", BER = " << scientific << setprecision(2) << ber << endl;
+      if (fecf)
+      {
+        cout << "  frames passing the FECF: " << delivered_frames << "/" << total_frames << endl;
+      }
       //results << "Eb/N0 (dB) = " << EbN0_values[i] << ", BER = " << ber << endl;
       results <<  EbN0_values[i] << " " << ber << endl;
+#ifdef RS_STATS
+      if (mode != ONLY_CC)
+      {
+          decoder.stats().print(stdout);
+          decoder.reset_stats();
+      }
+#endif
   }
       
   results.close();
+  vitfilt27_block_free(&vb);
   return 0;
 }
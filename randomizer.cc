@@ -0,0 +1,234 @@
+// LFSR randomizers applied with wide XORs
+//
+// A randomizer sequence is generated once and stored over a whole frame
+// plus one period (the CCSDS one repeats every SCRAMBLER_POLY_LEN bytes),
+// so the sequence of a frame (or a part of it) starting at any phase is a
+// contiguous slice and randomizing is a plain vectorized XOR of two byte
+// arrays. No link runs a bitwise LFSR per frame.
+
+#include "randomizer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ccsds.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RANDOMIZER_X86 1
+#include <immintrin.h>
+#endif
+
+#define SCRAMBLER_EXT_LEN (CODEWORD_MAX_LEN + SCRAMBLER_POLY_LEN)
+#define CCSDS_RANDOMIZER_POLY 0x1a9
+#define HIGH_RATE_RANDOMIZER_POLY 0x24001
+// longest byte period repeated in a randomizer's table, that of the high
+// rate randomizer
+#define MAX_TABLE_PERIOD ((1u << 17) - 1)
+
+alignas(64) static constexpr lfsr_table<SCRAMBLER_EXT_LEN> s_sequence =
+    make_lfsr_table<SCRAMBLER_EXT_LEN>(CCSDS_RANDOMIZER_POLY, 0xff);
+
+static constexpr bool matches_scrambler_poly()
+{
+    for (int i = 0; i < SCRAMBLER_POLY_LEN; i++)
+    {
+        if (s_sequence.seq[i] != SCRAMBLER_POLY[i]) return false;
+    }
+    return true;
+}
+static_assert(matches_scrambler_poly(), "LFSR 0x1a9 doesn't reproduce SCRAMBLER_POLY");
+
+// 8 bytes at a time, in and out may overlap as documented, so every word is
+// loaded before it is stored
+static void xor_generic(const uint8_t* in, const uint8_t* seq, size_t len, uint8_t* out)
+{
+    size_t j = 0;
+    for (; j + 8 <= len; j += 8)
+    {
+        uint64_t a, b;
+        memcpy(&a, &in[j], 8);
+        memcpy(&b, &seq[j], 8);
+        a ^= b;
+        memcpy(&out[j], &a, 8);
+    }
+    for (; j < len; j++) out[j] = in[j] ^ seq[j];
+}
+
+#ifdef RANDOMIZER_X86
+__attribute__((target("sse2")))
+static void xor_sse2(const uint8_t* in, const uint8_t* seq, size_t len, uint8_t* out)
+{
+    size_t j = 0;
+    for (; j + 16 <= len; j += 16)
+    {
+        const __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&in[j]),
+                                        _mm_loadu_si128((const __m128i*)&seq[j]));
+        _mm_storeu_si128((__m128i*)&out[j], v);
+    }
+    xor_generic(&in[j], &seq[j], len - j, &out[j]);
+}
+
+__attribute__((target("avx2")))
+static void xor_avx2(const uint8_t* in, const uint8_t* seq, size_t len, uint8_t* out)
+{
+    size_t j = 0;
+    for (; j + 32 <= len; j += 32)
+    {
+        const __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&in[j]),
+                                           _mm256_loadu_si256((const __m256i*)&seq[j]));
+        _mm256_storeu_si256((__m256i*)&out[j], v);
+    }
+    if (j + 16 <= len)
+    {
+        const __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&in[j]),
+                                        _mm_loadu_si128((const __m128i*)&seq[j]));
+        _mm_storeu_si128((__m128i*)&out[j], v);
+        j += 16;
+    }
+    xor_generic(&in[j], &seq[j], len - j, &out[j]);
+}
+#endif
+
+typedef void (*xor_fn)(const uint8_t*, const uint8_t*, size_t, uint8_t*);
+
+struct xor_kernel
+{
+    const char* name;
+    xor_fn fn;
+};
+
+static const xor_kernel* select_kernel()
+{
+    static const xor_kernel generic = {"generic", xor_generic};
+#ifdef RANDOMIZER_X86
+    static const xor_kernel sse2 = {"sse2", xor_sse2};
+    static const xor_kernel avx2 = {"avx2", xor_avx2};
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return &avx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return &sse2;
+    }
+#endif
+    return &generic;
+}
+
+static const xor_kernel& kernel()
+{
+    static const xor_kernel* k = select_kernel();
+    return *k;
+}
+
+void xor_sequence(const uint8_t* in, const uint8_t* seq, size_t len, uint8_t* out)
+{
+    kernel().fn(in, seq, len, out);
+}
+
+bool randomizer_from_string(const char* name, randomizer_t* type)
+{
+    if (strcasecmp(name, "ccsds") == 0)
+    {
+        *type = RANDOMIZER_CCSDS;
+        return true;
+    }
+    if (strcasecmp(name, "high_rate") == 0)
+    {
+        *type = RANDOMIZER_HIGH_RATE;
+        return true;
+    }
+    return false;
+}
+
+static size_t gcd(size_t a, size_t b)
+{
+    while (b)
+    {
+        const size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// byte period of the sequence, 0 if it doesn't return to the seed within
+// MAX_TABLE_PERIOD bytes (or not at all, for singular polynomials)
+static size_t byte_period(uint32_t poly, uint32_t seed)
+{
+    lfsr reg(poly, seed);
+    const uint32_t start = reg.state;
+    for (size_t bits = 1; bits <= 8 * (size_t)MAX_TABLE_PERIOD; bits++)
+    {
+        reg.next_bit();
+        if (reg.state == start)
+        {
+            const size_t period = bits / gcd(bits, 8);
+            return period <= MAX_TABLE_PERIOD ? period : 0;
+        }
+    }
+    return 0;
+}
+
+randomizer::randomizer(uint32_t poly, uint32_t seed, size_t max_len)
+    : d_poly(poly), d_seed(seed), d_period(byte_period(poly, seed))
+{
+    d_storage.resize(max_len + d_period);
+    lfsr reg(poly, seed);
+    for (uint8_t& b : d_storage) b = reg.next_byte();
+    d_seq = d_storage.data();
+    d_len = d_storage.size();
+}
+
+randomizer::randomizer(uint32_t poly, uint32_t seed, const uint8_t* seq, size_t len, size_t period)
+    : d_poly(poly), d_seed(seed), d_seq(seq), d_len(len), d_period(period)
+{
+}
+
+const randomizer& randomizer::get(randomizer_t type)
+{
+    static const randomizer ccsds(CCSDS_RANDOMIZER_POLY, 0xff, s_sequence.seq, SCRAMBLER_EXT_LEN,
+                                  SCRAMBLER_POLY_LEN);
+    if (type == RANDOMIZER_HIGH_RATE)
+    {
+        static const randomizer high_rate(HIGH_RATE_RANDOMIZER_POLY, 0x1ffff, CODEWORD_MAX_LEN);
+        return high_rate;
+    }
+    return ccsds;
+}
+
+void randomizer::apply(const uint8_t* in, size_t len, size_t offset, uint8_t* out) const
+{
+    const xor_fn fn = kernel().fn;
+    size_t pos = d_period ? offset % d_period : offset;
+    // a single slice unless len exceeds the table
+    while (len > 0)
+    {
+        if (pos >= d_len)
+        {
+            fprintf(stderr, "randomizer: sequence of 0x%x ends at byte %zu\n", d_poly, d_len);
+            if (out != in) memmove(out, in, len);
+            return;
+        }
+        const size_t n = len < d_len - pos ? len : d_len - pos;
+        fn(in, &d_seq[pos], n, out);
+        in += n;
+        out += n;
+        len -= n;
+        pos += n;
+        if (d_period) pos %= d_period;
+    }
+}
+
+void randomize(const uint8_t* in, size_t len, size_t offset, uint8_t* out)
+{
+    randomizer::get(RANDOMIZER_CCSDS).apply(in, len, offset, out);
+}
+
+const char* randomizer_kernel()
+{
+    return kernel().name;
+}
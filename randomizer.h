@@ -0,0 +1,163 @@
+#ifndef INCLUDED_RANDOMIZER_H
+#define INCLUDED_RANDOMIZER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/**
+ * out[j] = in[j] ^ seq[j] for j < len, 32 or 16 bytes at a time (AVX2 or
+ * SSE2, chosen once at runtime from the CPU features). in may equal out or
+ * lie behind it (out <= in), the bytes are processed front to back.
+ */
+void xor_sequence(const uint8_t* in, const uint8_t* seq, size_t len, uint8_t* out);
+
+/**
+ * Copies len bytes while adding (or removing, it is self inverse) the CCSDS
+ * randomizer (SCRAMBLER_POLY), starting at byte offset of its sequence,
+ * e.g. the position of the bytes in the codeword. The sequence is
+ * precomputed over a whole codeword from every phase, so there is no
+ * per-byte modulo. in and out as for xor_sequence().
+ */
+void randomize(const uint8_t* in, size_t len, size_t offset, uint8_t* out);
+
+/**
+ * @return Name of the XOR kernel selected for this CPU
+ */
+const char* randomizer_kernel();
+
+// the randomizers of the CCSDS TM synchronization and channel coding book
+enum randomizer_t
+{
+    RANDOMIZER_CCSDS,     // x^8 + x^7 + x^5 + x^3 + 1, 255 bit period
+    RANDOMIZER_HIGH_RATE, // x^17 + x^14 + 1, 2^17 - 1 bit period
+};
+
+bool randomizer_from_string(const char* name, randomizer_t* type);
+
+/*
+ * Fibonacci LFSR of a randomizer. poly has the coefficient of x^k in bit k
+ * (e.g. 0x1a9 for x^8 + x^7 + x^5 + x^3 + 1), the first degree output bits
+ * are seed, MSB first, and every following bit is the XOR of the bits
+ * degree - k back for the other terms x^k of poly. The output is packed MSB
+ * first. constexpr, so that fixed sequences are tables built by the compiler.
+ */
+struct lfsr
+{
+    uint32_t state;  // the next degree output bits, MSB first
+    uint32_t taps;
+    int degree;
+
+    static constexpr int degree_of(uint32_t poly)
+    {
+        int m = 0;
+        while (m < 31 && (poly >> (m + 1))) m++;
+        return m;
+    }
+
+    constexpr lfsr(uint32_t poly, uint32_t seed) : state(0), taps(0), degree(degree_of(poly))
+    {
+        for (int k = 0; k < degree; k++)
+        {
+            if (poly & (1u << k)) taps |= 1u << (degree - 1 - k);
+        }
+        state = seed & mask();
+    }
+
+    constexpr uint32_t mask() const { return (1u << degree) - 1; }
+
+    constexpr int next_bit()
+    {
+        const int out = (state >> (degree - 1)) & 1;
+        uint32_t t = state & taps;
+        int feedback = 0;
+        for (; t; t &= t - 1) feedback ^= 1;
+        state = ((state << 1) | feedback) & mask();
+        return out;
+    }
+
+    constexpr uint8_t next_byte()
+    {
+        uint8_t b = 0;
+        for (int i = 0; i < 8; i++) b = (b << 1) | next_bit();
+        return b;
+    }
+};
+
+template <size_t N>
+struct lfsr_table
+{
+    uint8_t seq[N];
+};
+
+/**
+ * The first N bytes of the sequence of lfsr(poly, seed), for constexpr
+ * tables.
+ */
+template <size_t N>
+constexpr lfsr_table<N> make_lfsr_table(uint32_t poly, uint32_t seed)
+{
+    lfsr_table<N> t = {};
+    lfsr reg(poly, seed);
+    for (size_t i = 0; i < N; i++) t.seq[i] = reg.next_byte();
+    return t;
+}
+
+/**
+ * A randomizer sequence, precomputed so that it is applied with
+ * xor_sequence(). CCSDS restarts the randomizer with every frame, so the
+ * sequence is only needed over a frame: it is stored over max_len bytes
+ * and, if its byte period (bit period / gcd(bit period, 8)) is at most
+ * 2^17 - 1, repeated for one more period, so that any offset is a
+ * contiguous slice and frames of any length work. Immutable once built,
+ * so one randomizer can be shared by any number of encoders and decoders
+ * on any threads.
+ */
+class randomizer
+{
+public:
+    /**
+     * Generates the sequence of lfsr(poly, seed), degree 2..31.
+     *
+     * @param max_len Bytes covered without wrapping, e.g. the frame length
+     */
+    randomizer(uint32_t poly, uint32_t seed, size_t max_len);
+
+    randomizer(const randomizer&) = delete;
+    randomizer& operator=(const randomizer&) = delete;
+
+    /**
+     * The CCSDS randomizers, seeded with all ones, over CODEWORD_MAX_LEN.
+     * RANDOMIZER_CCSDS is a constexpr table, the longer RANDOMIZER_HIGH_RATE
+     * sequence is generated on the first call.
+     */
+    static const randomizer& get(randomizer_t type);
+
+    /**
+     * Copies len bytes while adding the sequence from byte offset on, see
+     * randomize(). Bytes past max_len of a sequence that isn't periodic
+     * within the table are copied as they are, with an error message.
+     */
+    void apply(const uint8_t* in, size_t len, size_t offset, uint8_t* out) const;
+
+    // in place, e.g. on a sequence of zeros to get the sequence itself
+    void apply(uint8_t* data, size_t len, size_t offset = 0) const { apply(data, len, offset, data); }
+
+    uint32_t poly() const { return d_poly; }
+    uint32_t seed() const { return d_seed; }
+    // byte period, 0 if longer than the table
+    size_t period() const { return d_period; }
+
+private:
+    // the constexpr CCSDS table
+    randomizer(uint32_t poly, uint32_t seed, const uint8_t* seq, size_t len, size_t period);
+
+    uint32_t d_poly;
+    uint32_t d_seed;
+    std::vector<uint8_t> d_storage;
+    const uint8_t* d_seq;
+    size_t d_len;     // bytes of d_seq
+    size_t d_period;
+};
+
+#endif /* INCLUDED_RANDOMIZER_H */
@@ -1,48 +1,175 @@
 
-
 #include "reed_solomon.h"
 
 #include <stdint.h>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
 
-extern "C" {
-#include "fec-3.0.1/fec.h"
-}
 #include "ccsds.h"
+#include "rs_codec.h"
+#include "rs_syndrome.h"
+#include "rs_parity.h"
+#include "rs_stats.h"
 
-extern unsigned char CCSDS_alpha_to[];
-extern unsigned char CCSDS_index_of[];
-extern unsigned char CCSDS_poly[];
-extern unsigned char Taltab[];
-extern unsigned char Tal1tab[];
+// entry points of one rs_codec instantiation
+struct rs_code_ops
+{
+    int block_len;
+    int data_len;
+    int parity_len;
+    void (*parity)(const uint8_t *data, uint8_t *parity, int n_interleave, bool use_dual_basis, int pad);
+    uint32_t (*syndromes)(const uint8_t *data, int n_interleave, uint8_t (*syn)[RS_PARITY_LEN], bool use_dual_basis,
+                          int pad);
+    int (*decode)(uint8_t *data, const uint8_t *syn, int *eras_pos, int no_eras, bool use_dual_basis, int pad);
+};
 
+template <class Codec>
+static int decode_block(uint8_t *data, const uint8_t *syn, int *eras_pos, int no_eras, bool use_dual_basis, int pad)
+{
+    if (use_dual_basis)
+    {
+        return Codec::decode_dual(data, syn, eras_pos, no_eras, pad);
+    }
+    else
+    {
+        return Codec::decode(data, syn, eras_pos, no_eras, pad);
+    }
+}
 
+template <class Codec>
+static const rs_code_ops s_code_ops = {
+    Codec::BLOCK_LEN,
+    Codec::DATA_LEN,
+    Codec::NROOTS,
+    rs_parity_interleaved<Codec>,
+    rs_syndromes_interleaved<Codec>,
+    decode_block<Codec>,
+};
 
-reed_solomon::reed_solomon() {}
+reed_solomon::reed_solomon(rs_code_t code, int virtual_fill)
+{
+    switch (code)
+    {
+        case RS_CODE_255_239: d_ops = &s_code_ops<rs_ccsds_e8>; break;
+        case RS_CODE_255_223:
+        default:              d_ops = &s_code_ops<rs_ccsds_e16>; break;
+    }
+    d_pad = std::min(std::max(virtual_fill, 0), d_ops->data_len - 1);
+    d_max_erasures = d_ops->parity_len / 2;
+}
 reed_solomon::~reed_solomon() {}
 
+int reed_solomon::block_len() const { return d_ops->block_len - d_pad; }
+int reed_solomon::data_len() const { return d_ops->data_len - d_pad; }
+int reed_solomon::parity_len() const { return d_ops->parity_len; }
+
 void reed_solomon::encode(uint8_t *data, bool use_dual_basis)
 {
-    if (use_dual_basis)
+    d_ops->parity(data, &data[data_len()], 1, use_dual_basis, d_pad);
+}
+
+void reed_solomon::encode_interleaved(const uint8_t *data, uint8_t *parity, int n_interleave, bool use_dual_basis)
+{
+    d_ops->parity(data, parity, n_interleave, use_dual_basis, d_pad);
+}
+
+int16_t reed_solomon::decode(uint8_t *data, bool use_dual_basis)
+{
+    uint8_t syn[1][RS_PARITY_LEN];
+    if (!syndromes(data, 1, syn, use_dual_basis))
     {
-        encode_rs_ccsds(data, &data[RS_DATA_LEN],0);
+        // valid codeword, nothing to correct
+        return 0;
     }
-    else
+    return decode_with_syndromes(data, syn[0], use_dual_basis);
+}
+
+int16_t reed_solomon::decode(uint8_t *data, const uint8_t *reliability, bool use_dual_basis)
+{
+    uint8_t syn[1][RS_PARITY_LEN];
+    if (!syndromes(data, 1, syn, use_dual_basis))
     {
-        encode_rs_8(data, &data[RS_DATA_LEN], 0);
+        return 0;
     }
+    return decode_with_syndromes(data, syn[0], reliability, use_dual_basis);
 }
 
-int16_t reed_solomon::decode(uint8_t *data, bool use_dual_basis)
+int16_t reed_solomon::decode_with_syndromes(uint8_t *data, const uint8_t *syn, bool use_dual_basis)
 {
-    if (use_dual_basis)
+    return d_ops->decode(data, syn, 0, 0, use_dual_basis, d_pad);
+}
+
+int16_t reed_solomon::decode_with_syndromes(uint8_t *data, const uint8_t *syn, const uint8_t *reliability, bool use_dual_basis)
+{
+    int16_t nerrors = decode_with_syndromes(data, syn, use_dual_basis);
+    if (nerrors >= 0 || !reliability || d_max_erasures < RS_ERASURE_STEP)
     {
-        return decode_rs_ccsds(data, 0, 0, 0);
+        return nerrors;
     }
-    else
+
+    const int n = block_len();
+
+    // symbol positions, least reliable first
+    int order[RS_BLOCK_LEN];
+    for (int i = 0; i < n; i++)
     {
-        return decode_rs_8(data, 0, 0, 0);
+        order[i] = i;
+    }
+    std::partial_sort(order, order + d_max_erasures, order + n,
+                      [reliability](int a, int b) {
+                          return reliability[a] < reliability[b] || (reliability[a] == reliability[b] && a < b);
+                      });
+
+    uint8_t received[RS_BLOCK_LEN];
+    memcpy(received, data, n);
+
+    for (int no_eras = RS_ERASURE_STEP; no_eras <= d_max_erasures; no_eras += RS_ERASURE_STEP)
+    {
+        int eras_pos[RS_PARITY_LEN];
+        memcpy(eras_pos, order, no_eras * sizeof(int));
+
+        int count = d_ops->decode(data, syn, eras_pos, no_eras, use_dual_basis, d_pad);
+
+        if (count < 0) continue;
+        // 2 * errors + erasures must not exceed the redundancy of the code
+        if (2 * count - no_eras <= d_ops->parity_len) return count;
+        memcpy(data, received, n);
     }
+    return -1;
+}
+
+void reed_solomon::set_max_erasures(int max_erasures)
+{
+    d_max_erasures = std::min(std::max(max_erasures, 0), d_ops->parity_len);
+}
+
+uint32_t reed_solomon::syndromes(const uint8_t *data, int n_interleave, uint8_t (*syn)[RS_PARITY_LEN], bool use_dual_basis)
+{
+    RS_STATS_SAMPLE_START(RS_STAGE_SYNDROME, start);
+    uint32_t dirty = d_ops->syndromes(data, n_interleave, syn, use_dual_basis, d_pad);
+    RS_STATS_SAMPLE_END(RS_STAGE_SYNDROME, start);
+    return dirty;
+}
 
+bool rs_code_from_string(const char *name, rs_code_t *code)
+{
+    int n = 0, k = 0;
+    char sep = 0;
+    if (sscanf(name, "%d%c%d", &n, &sep, &k) != 3 || (sep != ',' && sep != '/' && sep != '_'))
+    {
+        return false;
+    }
+    if (n == 255 && k == 223)
+    {
+        *code = RS_CODE_255_223;
+        return true;
+    }
+    if (n == 255 && k == 239)
+    {
+        *code = RS_CODE_255_239;
+        return true;
+    }
+    return false;
 }
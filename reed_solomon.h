@@ -3,20 +3,80 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "ccsds.h"
 
 
 
+// erasure counts tried by the reliability based decoder: RS_ERASURE_STEP, 2*RS_ERASURE_STEP, ...
+#define RS_ERASURE_STEP 4
+
+// CCSDS 131.0-B Reed-Solomon codes, see rs_codec.h
+enum rs_code_t
+{
+    RS_CODE_255_223, // E=16
+    RS_CODE_255_239, // E=8
+};
+
+struct rs_code_ops;
+
 class reed_solomon
 {
     private:
+        const rs_code_ops *d_ops;
+        int d_pad;
+        int d_max_erasures;
+
     public:
-        reed_solomon();
+        /**
+         * @param virtual_fill Shortens the code by this many leading zero
+         *                     symbols (CCSDS virtual fill), which are neither
+         *                     stored nor processed; 0..data length - 1
+         */
+        reed_solomon(rs_code_t code = RS_CODE_255_223, int virtual_fill = 0);
         ~reed_solomon();
 
+        // code dimensions, virtual fill excluded
+        int block_len() const;
+        int data_len() const;
+        int parity_len() const;
+        int virtual_fill() const { return d_pad; }
+
         void encode(uint8_t *data, bool use_dual_basis);
+        void encode_interleaved(const uint8_t *data, uint8_t *parity, int n_interleave, bool use_dual_basis);
         int16_t decode(uint8_t *data, bool use_dual_basis);
+
+        /**
+         * Errors-and-erasures decoding. If the block can't be corrected
+         * with errors only, the least reliable symbols are declared erased,
+         * RS_ERASURE_STEP more per attempt, up to max_erasures().
+         *
+         * @param reliability One reliability value per symbol, lower is less reliable
+         * @return            Number of corrected symbols or -1
+         */
+        int16_t decode(uint8_t *data, const uint8_t *reliability, bool use_dual_basis);
+
+        int16_t decode_with_syndromes(uint8_t *data, const uint8_t *syn, bool use_dual_basis);
+        int16_t decode_with_syndromes(uint8_t *data, const uint8_t *syn, const uint8_t *reliability, bool use_dual_basis);
+
+        uint32_t syndromes(const uint8_t *data, int n_interleave, uint8_t (*syn)[RS_PARITY_LEN], bool use_dual_basis);
+
+        /**
+         * Every erasure costs one parity symbol of error detection; with
+         * all parity_len() erased any received block "decodes". Clamped to
+         * 0..parity_len(), default parity_len() / 2.
+         */
+        void set_max_erasures(int max_erasures);
+        int max_erasures() const { return d_max_erasures; }
 };
 
+/**
+ * Parses a code name as used in the config file ("255,223" or "255,239",
+ * separated by ',', '/' or '_').
+ *
+ * @return false if the name is not one of the supported codes
+ */
+bool rs_code_from_string(const char *name, rs_code_t *code);
+
 
 
 #endif /* INCLUDED_REED_SOLOMON_H */
@@ -0,0 +1,434 @@
+#ifndef INCLUDED_RS_CODEC_H
+#define INCLUDED_RS_CODEC_H
+
+// Reed-Solomon codec with all tables generated at compile time
+//
+// The encoder and decoder are ports of encode_rs.h/decode_rs.h from libfec
+// 3.0.1, Copyright 2002-2004 Phil Karn, KA9Q, used under the terms of the
+// GNU Lesser General Public License (see fec-3.0.1/lesser.txt).
+
+#include <stdint.h>
+#include <string.h>
+#include "rs_stats.h"
+
+/**
+ * Galois field and generator polynomial tables of a RS code, built by
+ * rs_make_tables() during compilation.
+ */
+template <int SymSize, int NRoots>
+struct rs_tables
+{
+    static constexpr int NN = (1 << SymSize) - 1;
+
+    uint8_t alpha_to[NN + 1];     // index form -> poly form
+    uint8_t index_of[NN + 1];     // poly form -> index form
+    uint8_t genpoly[NRoots + 1];  // generator polynomial, index form
+    uint8_t taltab[NN + 1];       // conventional -> dual basis (CCSDS field only)
+    uint8_t tal1tab[NN + 1];      // dual -> conventional basis
+    int iprim;                    // prim-th root of 1, index form
+    bool primitive;               // gfpoly is a primitive polynomial
+};
+
+template <int SymSize, int GfPoly, int NRoots, int Fcr, int Prim>
+constexpr rs_tables<SymSize, NRoots> rs_make_tables()
+{
+    constexpr int NN = (1 << SymSize) - 1;
+    rs_tables<SymSize, NRoots> t{};
+
+    // Galois field lookup tables
+    t.index_of[0] = NN; // log(zero) = -inf
+    t.alpha_to[NN] = 0; // alpha**-inf = 0
+    int sr = 1;
+    for (int i = 0; i < NN; i++)
+    {
+        t.index_of[sr] = i;
+        t.alpha_to[i] = sr;
+        sr <<= 1;
+        if (sr & (1 << SymSize)) sr ^= GfPoly;
+        sr &= NN;
+    }
+    t.primitive = (sr == 1);
+
+    // prim-th root of 1, used in decoding
+    int iprim = 1;
+    while ((iprim % Prim) != 0) iprim += NN;
+    t.iprim = iprim / Prim;
+
+    // RS code generator polynomial from its roots
+    auto modnn = [](int x) {
+        while (x >= NN)
+        {
+            x -= NN;
+            x = (x >> SymSize) + (x & NN);
+        }
+        return x;
+    };
+    t.genpoly[0] = 1;
+    for (int i = 0, root = Fcr * Prim; i < NRoots; i++, root += Prim)
+    {
+        t.genpoly[i + 1] = 1;
+        for (int j = i; j > 0; j--)
+        {
+            if (t.genpoly[j] != 0)
+                t.genpoly[j] = t.genpoly[j - 1] ^ t.alpha_to[modnn(t.index_of[t.genpoly[j]] + root)];
+            else
+                t.genpoly[j] = t.genpoly[j - 1];
+        }
+        t.genpoly[0] = t.alpha_to[modnn(t.index_of[t.genpoly[0]] + root)];
+    }
+    for (int i = 0; i <= NRoots; i++)
+        t.genpoly[i] = t.index_of[t.genpoly[i]];
+
+    // Berlekamp's dual basis representation (l0, l1, ... l7) as used by
+    // CCSDS; only defined for the CCSDS field, identity otherwise
+    const uint8_t tal[8] = {0x8d, 0xef, 0xec, 0x86, 0xfa, 0x99, 0xaf, 0x7b};
+    for (int i = 0; i <= NN; i++)
+    {
+        t.taltab[i] = i;
+        if (SymSize == 8 && GfPoly == 0x187)
+        {
+            t.taltab[i] = 0;
+            for (int j = 0; j < 8; j++)
+                for (int k = 0; k < 8; k++)
+                    if (i & (1 << k)) t.taltab[i] ^= tal[7 - k] & (1 << j);
+        }
+        t.tal1tab[t.taltab[i]] = i;
+    }
+    return t;
+}
+
+/**
+ * RS(N,K) code over GF(2^SymSize) with field generator polynomial GfPoly,
+ * first consecutive root Fcr and primitive element Prim (index form).
+ * N < 2^SymSize - 1 gives a shortened code, the leading 2^SymSize - 1 - N
+ * symbols being virtual zeros.
+ *
+ * All member functions work on the conventional basis, except the _dual
+ * variants which take CCSDS dual basis symbols. The dual basis map is linear
+ * over GF(2), so they keep the received symbols and the parity register in
+ * the dual basis and convert single table entries instead of whole blocks.
+ */
+template <int SymSize, int N, int K, int GfPoly, int Fcr, int Prim>
+class rs_codec
+{
+public:
+    static_assert(SymSize >= 2 && SymSize <= 8, "symbols are stored in bytes");
+
+    static constexpr int MM = SymSize;
+    static constexpr int NN = (1 << SymSize) - 1;
+    static constexpr int BLOCK_LEN = N;
+    static constexpr int DATA_LEN = K;
+    static constexpr int NROOTS = N - K;
+    static constexpr int PAD = NN - N;
+    static constexpr int FCR = Fcr;
+    static constexpr int PRIM = Prim;
+    static constexpr int A0 = NN; // zero in index form
+
+    static_assert(N <= NN && K > 0 && K < N, "invalid code dimensions");
+
+    static constexpr rs_tables<SymSize, N - K> tables = rs_make_tables<SymSize, GfPoly, N - K, Fcr, Prim>();
+    static constexpr int IPRIM = tables.iprim;
+
+    static_assert(tables.primitive, "field generator polynomial is not primitive");
+
+    static constexpr int modnn(int x)
+    {
+        while (x >= NN)
+        {
+            x -= NN;
+            x = (x >> MM) + (x & NN);
+        }
+        return x;
+    }
+
+    /**
+     * Computes the NROOTS parity symbols of DATA_LEN - pad data symbols.
+     */
+    static void encode(const uint8_t *data, uint8_t *parity, int pad = 0)
+    {
+        encode_basis<false>(data, parity, pad);
+    }
+
+    static void encode_dual(const uint8_t *data, uint8_t *parity, int pad = 0)
+    {
+        encode_basis<true>(data, parity, pad);
+    }
+
+    /**
+     * Evaluates the BLOCK_LEN - pad received symbols at the roots of the
+     * generator polynomial.
+     *
+     * @param syn Output, NROOTS syndromes in poly form
+     * @return    true if any syndrome is non-zero
+     */
+    static bool syndromes(const uint8_t *data, uint8_t *syn, int pad = 0)
+    {
+        return syndromes_basis<false>(data, syn, pad);
+    }
+
+    static bool syndromes_dual(const uint8_t *data, uint8_t *syn, int pad = 0)
+    {
+        return syndromes_basis<true>(data, syn, pad);
+    }
+
+    /**
+     * Errors and erasures decoding of BLOCK_LEN - pad symbols, corrected in place.
+     *
+     * @param syn      NROOTS syndromes in poly form, see syndromes()
+     * @param eras_pos Erasure positions (block indices), overwritten with the
+     *                 positions of all corrected symbols; may be NULL
+     * @param no_eras  Number of erasures
+     * @return         Number of corrected symbols or -1 if uncorrectable
+     */
+    static int decode(uint8_t *data, const uint8_t *syn, int *eras_pos, int no_eras, int pad = 0)
+    {
+        return decode_basis<false>(data, syn, eras_pos, no_eras, pad);
+    }
+
+    static int decode_dual(uint8_t *data, const uint8_t *syn, int *eras_pos, int no_eras, int pad = 0)
+    {
+        return decode_basis<true>(data, syn, eras_pos, no_eras, pad);
+    }
+
+private:
+    static constexpr uint8_t to_conventional(uint8_t x, bool dual) { return dual ? tables.tal1tab[x] : x; }
+    static constexpr uint8_t from_conventional(uint8_t x, bool dual) { return dual ? tables.taltab[x] : x; }
+
+    template <bool dual>
+    static void encode_basis(const uint8_t *data, uint8_t *parity, int pad)
+    {
+        memset(parity, 0, NROOTS);
+        for (int i = 0; i < K - pad; i++)
+        {
+            int feedback = tables.index_of[to_conventional(data[i] ^ parity[0], dual)];
+            if (feedback != A0)
+            {
+                for (int j = 1; j < NROOTS; j++)
+                    parity[j] ^= from_conventional(tables.alpha_to[modnn(feedback + tables.genpoly[NROOTS - j])], dual);
+            }
+            memmove(&parity[0], &parity[1], NROOTS - 1);
+            if (feedback != A0)
+                parity[NROOTS - 1] = from_conventional(tables.alpha_to[modnn(feedback + tables.genpoly[0])], dual);
+            else
+                parity[NROOTS - 1] = 0;
+        }
+    }
+
+    template <bool dual>
+    static bool syndromes_basis(const uint8_t *data, uint8_t *syn, int pad)
+    {
+        for (int i = 0; i < NROOTS; i++)
+            syn[i] = to_conventional(data[0], dual);
+
+        for (int j = 1; j < N - pad; j++)
+        {
+            uint8_t d = to_conventional(data[j], dual);
+            for (int i = 0; i < NROOTS; i++)
+            {
+                if (syn[i] == 0)
+                    syn[i] = d;
+                else
+                    syn[i] = d ^ tables.alpha_to[modnn(tables.index_of[syn[i]] + (FCR + i) * PRIM)];
+            }
+        }
+
+        uint8_t any = 0;
+        for (int i = 0; i < NROOTS; i++)
+            any |= syn[i];
+        return any != 0;
+    }
+
+    template <bool dual>
+    static int decode_basis(uint8_t *data, const uint8_t *syn, int *eras_pos, int no_eras, int pad)
+    {
+        const uint8_t *alpha_to = tables.alpha_to;
+        const uint8_t *index_of = tables.index_of;
+        int deg_lambda, el, deg_omega;
+        int i, j, r, k;
+        uint8_t u, q, tmp, num1, num2, den, discr_r;
+        uint8_t lambda[NROOTS + 1], s[NROOTS]; // err+eras locator poly and syndrome poly
+        uint8_t b[NROOTS + 1], t[NROOTS + 1], omega[NROOTS + 1];
+        uint8_t root[NROOTS], reg[NROOTS + 1], loc[NROOTS];
+        int syn_error, count;
+        RS_STATS_START(stage_start);
+
+        // virtual fill in front of the received symbols, code shortening included
+        pad += PAD;
+
+        // convert syndromes to index form, checking for nonzero condition
+        syn_error = 0;
+        for (i = 0; i < NROOTS; i++)
+        {
+            syn_error |= syn[i];
+            s[i] = index_of[syn[i]];
+        }
+
+        if (!syn_error)
+        {
+            // data[] is a codeword, there are no errors to correct
+            count = 0;
+            goto finish;
+        }
+        memset(&lambda[1], 0, NROOTS * sizeof(lambda[0]));
+        lambda[0] = 1;
+
+        if (no_eras > 0)
+        {
+            // init lambda to be the erasure locator polynomial
+            lambda[1] = alpha_to[modnn(PRIM * (NN - 1 - (eras_pos[0] + pad)))];
+            for (i = 1; i < no_eras; i++)
+            {
+                u = modnn(PRIM * (NN - 1 - (eras_pos[i] + pad)));
+                for (j = i + 1; j > 0; j--)
+                {
+                    tmp = index_of[lambda[j - 1]];
+                    if (tmp != A0)
+                        lambda[j] ^= alpha_to[modnn(u + tmp)];
+                }
+            }
+        }
+        for (i = 0; i < NROOTS + 1; i++)
+            b[i] = index_of[lambda[i]];
+
+        // Berlekamp-Massey algorithm to determine the error+erasure locator polynomial
+        r = no_eras;
+        el = no_eras;
+        while (++r <= NROOTS)
+        {
+            // discrepancy at the r-th step in poly-form
+            discr_r = 0;
+            for (i = 0; i < r; i++)
+            {
+                if ((lambda[i] != 0) && (s[r - i - 1] != A0))
+                    discr_r ^= alpha_to[modnn(index_of[lambda[i]] + s[r - i - 1])];
+            }
+            discr_r = index_of[discr_r];
+            if (discr_r == A0)
+            {
+                // B(x) <-- x*B(x)
+                memmove(&b[1], b, NROOTS * sizeof(b[0]));
+                b[0] = A0;
+            }
+            else
+            {
+                // T(x) <-- lambda(x) - discr_r*x*b(x)
+                t[0] = lambda[0];
+                for (i = 0; i < NROOTS; i++)
+                {
+                    if (b[i] != A0)
+                        t[i + 1] = lambda[i + 1] ^ alpha_to[modnn(discr_r + b[i])];
+                    else
+                        t[i + 1] = lambda[i + 1];
+                }
+                if (2 * el <= r + no_eras - 1)
+                {
+                    el = r + no_eras - el;
+                    // B(x) <-- inv(discr_r) * lambda(x)
+                    for (i = 0; i <= NROOTS; i++)
+                        b[i] = (lambda[i] == 0) ? A0 : modnn(index_of[lambda[i]] - discr_r + NN);
+                }
+                else
+                {
+                    // B(x) <-- x*B(x)
+                    memmove(&b[1], b, NROOTS * sizeof(b[0]));
+                    b[0] = A0;
+                }
+                memcpy(lambda, t, (NROOTS + 1) * sizeof(t[0]));
+            }
+        }
+
+        // convert lambda to index form and compute deg(lambda(x))
+        deg_lambda = 0;
+        for (i = 0; i < NROOTS + 1; i++)
+        {
+            lambda[i] = index_of[lambda[i]];
+            if (lambda[i] != A0)
+                deg_lambda = i;
+        }
+        RS_STATS_STAGE(RS_STAGE_BM, stage_start);
+
+        // find roots of the error+erasure locator polynomial by Chien search
+        memcpy(&reg[1], &lambda[1], NROOTS * sizeof(reg[0]));
+        count = 0;
+        for (i = 1, k = IPRIM - 1; i <= NN; i++, k = modnn(k + IPRIM))
+        {
+            q = 1; // lambda[0] is always 0
+            for (j = deg_lambda; j > 0; j--)
+            {
+                if (reg[j] != A0)
+                {
+                    reg[j] = modnn(reg[j] + j);
+                    q ^= alpha_to[reg[j]];
+                }
+            }
+            if (q != 0)
+                continue; // not a root
+            // store root (index-form) and error location number
+            root[count] = i;
+            loc[count] = k;
+            // if we've already found max possible roots, abort the search to save time
+            if (++count == deg_lambda)
+                break;
+        }
+        RS_STATS_STAGE(RS_STAGE_CHIEN, stage_start);
+        if (deg_lambda != count)
+        {
+            // deg(lambda) unequal to number of roots => uncorrectable error detected
+            count = -1;
+            goto finish;
+        }
+
+        // err+eras evaluator poly omega(x) = s(x)*lambda(x) (modulo x**NROOTS) in index form
+        deg_omega = deg_lambda - 1;
+        for (i = 0; i <= deg_omega; i++)
+        {
+            tmp = 0;
+            for (j = i; j >= 0; j--)
+            {
+                if ((s[i - j] != A0) && (lambda[j] != A0))
+                    tmp ^= alpha_to[modnn(s[i - j] + lambda[j])];
+            }
+            omega[i] = index_of[tmp];
+        }
+
+        // error values in poly-form: num1 = omega(inv(X(l))), num2 =
+        // inv(X(l))**(FCR-1) and den = lambda_pr(inv(X(l)))
+        for (j = count - 1; j >= 0; j--)
+        {
+            num1 = 0;
+            for (i = deg_omega; i >= 0; i--)
+            {
+                if (omega[i] != A0)
+                    num1 ^= alpha_to[modnn(omega[i] + i * root[j])];
+            }
+            num2 = alpha_to[modnn(root[j] * (FCR - 1) + NN)];
+            den = 0;
+
+            // lambda[i+1] for i even is the formal derivative lambda_pr of lambda[i]
+            for (i = (deg_lambda < NROOTS - 1 ? deg_lambda : NROOTS - 1) & ~1; i >= 0; i -= 2)
+            {
+                if (lambda[i + 1] != A0)
+                    den ^= alpha_to[modnn(lambda[i + 1] + i * root[j])];
+            }
+            // apply error to data
+            if (num1 != 0 && loc[j] >= pad)
+            {
+                data[loc[j] - pad] ^= from_conventional(alpha_to[modnn(index_of[num1] + index_of[num2] + NN - index_of[den])], dual);
+            }
+        }
+        RS_STATS_STAGE(RS_STAGE_FORNEY, stage_start);
+    finish:
+        if (eras_pos != NULL)
+        {
+            for (i = 0; i < count; i++)
+                eras_pos[i] = loc[i] - pad;
+        }
+        return count;
+    }
+};
+
+// CCSDS 131.0-B codes: E=16 RS(255,223) and E=8 RS(255,239)
+typedef rs_codec<8, 255, 223, 0x187, 112, 11> rs_ccsds_e16;
+typedef rs_codec<8, 255, 239, 0x187, 120, 11> rs_ccsds_e8;
+
+#endif /* INCLUDED_RS_CODEC_H */
@@ -0,0 +1,213 @@
+// Fused (de)interleaving and randomizer removal for the CCSDS RS codewords
+//
+// An interleaved codeword is an n x I byte matrix, one row per symbol
+// position and one column per RS block; splitting it into blocks is a
+// transpose. The SSSE3 kernels transpose 16 rows at a time: every row is
+// read with one 8 byte load (the bytes past column I belong to the next
+// rows and are ignored), PSHUFB pairs the bytes of two rows into 16-bit
+// words and an 8x8 transpose of those words leaves 16 symbols of each
+// block in a register, to which the sequence is added before the store.
+// The inverse runs the same steps backwards with overlapping 8 byte stores,
+// each of which is completed by the one of the next row.
+
+#include "rs_interleave.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ccsds.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RS_INTERLEAVE_X86 1
+#include <immintrin.h>
+#endif
+
+template <int I>
+static void deinterleave_generic(const uint8_t* codeword, int n, const uint8_t* seq, uint8_t* blocks, int stride,
+                                 int j)
+{
+    for (int i = 0; i < I; i++)
+    {
+        const uint8_t* src = &codeword[i];
+        uint8_t* dst = &blocks[i * stride];
+        if (seq)
+        {
+            const uint8_t* s = &seq[i * stride];
+            for (int k = j; k < n; k++) dst[k] = src[k * I] ^ s[k];
+        }
+        else
+        {
+            for (int k = j; k < n; k++) dst[k] = src[k * I];
+        }
+    }
+}
+
+template <int I>
+static void interleave_generic(const uint8_t* blocks, int stride, int len, uint8_t* out, int j)
+{
+    for (int i = 0; i < I; i++)
+    {
+        const uint8_t* src = &blocks[i * stride];
+        uint8_t* dst = &out[i];
+        for (int k = j; k < len; k++) dst[k * I] = src[k];
+    }
+}
+
+template <int I>
+static void deinterleave_portable(const uint8_t* codeword, int n, const uint8_t* seq, uint8_t* blocks, int stride)
+{
+    deinterleave_generic<I>(codeword, n, seq, blocks, stride, 0);
+}
+
+template <int I>
+static void interleave_portable(const uint8_t* blocks, int stride, int len, uint8_t* out)
+{
+    interleave_generic<I>(blocks, stride, len, out, 0);
+}
+
+#ifdef RS_INTERLEAVE_X86
+// transposes the 8x8 matrix of 16-bit words in r
+__attribute__((target("ssse3"), always_inline))
+static inline void transpose_8x8_epi16(__m128i* r)
+{
+    const __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+    const __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+    const __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+    const __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+    const __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+    const __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+    const __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+    const __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+    const __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+    const __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+    const __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+    const __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+    const __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+    const __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+    const __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+    const __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+
+    r[0] = _mm_unpacklo_epi64(u0, u4);
+    r[1] = _mm_unpackhi_epi64(u0, u4);
+    r[2] = _mm_unpacklo_epi64(u1, u5);
+    r[3] = _mm_unpackhi_epi64(u1, u5);
+    r[4] = _mm_unpacklo_epi64(u2, u6);
+    r[5] = _mm_unpackhi_epi64(u2, u6);
+    r[6] = _mm_unpacklo_epi64(u3, u7);
+    r[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+template <int I>
+__attribute__((target("ssse3")))
+static void deinterleave_ssse3(const uint8_t* codeword, int n, const uint8_t* seq, uint8_t* blocks, int stride)
+{
+    // two rows of 8 bytes -> 8 words (row 2m, row 2m + 1) of column w
+    const __m128i pair = _mm_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+    int j = 0;
+    // the load of the last row of a group reads 8 - I bytes past it
+    for (; j + 16 <= n && (j + 15) * I + 8 <= n * I; j += 16)
+    {
+        __m128i r[8];
+        for (int m = 0; m < 8; m++)
+        {
+            const __m128i lo = _mm_loadl_epi64((const __m128i*)&codeword[(j + 2 * m) * I]);
+            const __m128i hi = _mm_loadl_epi64((const __m128i*)&codeword[(j + 2 * m + 1) * I]);
+            r[m] = _mm_shuffle_epi8(_mm_unpacklo_epi64(lo, hi), pair);
+        }
+        transpose_8x8_epi16(r);
+        for (int i = 0; i < I; i++)
+        {
+            __m128i v = r[i];
+            if (seq) v = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)&seq[i * stride + j]));
+            _mm_storeu_si128((__m128i*)&blocks[i * stride + j], v);
+        }
+    }
+    deinterleave_generic<I>(codeword, n, seq, blocks, stride, j);
+}
+
+template <int I>
+__attribute__((target("ssse3")))
+static void interleave_ssse3(const uint8_t* blocks, int stride, int len, uint8_t* out)
+{
+    // 8 words (row 2m, row 2m + 1) -> two rows of 8 bytes
+    const __m128i unpair = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    int j = 0;
+    // the store of the last row of a group writes 8 - I bytes past it
+    for (; j + 16 <= len && (j + 15) * I + 8 <= len * I; j += 16)
+    {
+        __m128i r[8];
+        for (int i = 0; i < 8; i++)
+        {
+            r[i] = i < I ? _mm_loadu_si128((const __m128i*)&blocks[i * stride + j]) : _mm_setzero_si128();
+        }
+        transpose_8x8_epi16(r);
+        // in row order, every store overwrites the spill of the previous one
+        for (int m = 0; m < 8; m++)
+        {
+            const __m128i v = _mm_shuffle_epi8(r[m], unpair);
+            _mm_storel_epi64((__m128i*)&out[(j + 2 * m) * I], v);
+            _mm_storel_epi64((__m128i*)&out[(j + 2 * m + 1) * I], _mm_srli_si128(v, 8));
+        }
+    }
+    interleave_generic<I>(blocks, stride, len, out, j);
+}
+#endif
+
+typedef void (*deinterleave_fn)(const uint8_t*, int, const uint8_t*, uint8_t*, int);
+typedef void (*interleave_fn)(const uint8_t*, int, int, uint8_t*);
+
+#define INTERLEAVE_FNS(kernel) { \
+    kernel<1>, kernel<2>, kernel<3>, kernel<4>, kernel<5>, kernel<6>, kernel<7>, kernel<8>, \
+}
+
+struct interleave_kernel
+{
+    const char* name;
+    deinterleave_fn deinterleave[RS_MAX_NBLOCKS];
+    interleave_fn interleave[RS_MAX_NBLOCKS];
+};
+
+static const interleave_kernel* select_kernel()
+{
+    static const interleave_kernel generic = {"generic", INTERLEAVE_FNS(deinterleave_portable),
+                                              INTERLEAVE_FNS(interleave_portable)};
+#ifdef RS_INTERLEAVE_X86
+    // a single block is a plain copy, which the compiler vectorizes
+    static const interleave_kernel ssse3 = {
+        "ssse3",
+        {deinterleave_portable<1>, deinterleave_ssse3<2>, deinterleave_ssse3<3>, deinterleave_ssse3<4>,
+         deinterleave_ssse3<5>, deinterleave_ssse3<6>, deinterleave_ssse3<7>, deinterleave_ssse3<8>},
+        {interleave_portable<1>, interleave_ssse3<2>, interleave_ssse3<3>, interleave_ssse3<4>,
+         interleave_ssse3<5>, interleave_ssse3<6>, interleave_ssse3<7>, interleave_ssse3<8>},
+    };
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return &ssse3;
+    }
+#endif
+    return &generic;
+}
+
+static const interleave_kernel& kernel()
+{
+    static const interleave_kernel* k = select_kernel();
+    return *k;
+}
+
+void rs_deinterleave(const uint8_t* codeword, int n_interleave, int n, const uint8_t* seq,
+                     uint8_t* blocks, int stride)
+{
+    kernel().deinterleave[n_interleave - 1](codeword, n, seq, blocks, stride);
+}
+
+void rs_interleave(const uint8_t* blocks, int stride, int n_interleave, int len, uint8_t* out)
+{
+    kernel().interleave[n_interleave - 1](blocks, stride, len, out);
+}
+
+const char* rs_interleave_kernel()
+{
+    return kernel().name;
+}
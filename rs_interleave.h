@@ -0,0 +1,32 @@
+#ifndef INCLUDED_RS_INTERLEAVE_H
+#define INCLUDED_RS_INTERLEAVE_H
+
+#include <stdint.h>
+
+/**
+ * Splits a codeword of n_interleave RS blocks in the CCSDS interleaved
+ * layout (symbol j of block i at codeword[i + j * n_interleave]) into
+ * contiguous blocks, blocks[i * stride + j], and adds seq on the way (e.g.
+ * the randomizer sequence, in the same layout as blocks) unless it is
+ * nullptr. Each codeword byte is read once; the kernel (SSSE3 8x16 byte
+ * transposes or portable C) is chosen once at runtime from the CPU features.
+ *
+ * @param n_interleave Interleaving depth, 1..RS_MAX_NBLOCKS
+ * @param n            Symbols per block
+ * @param stride       Distance of the blocks in blocks and seq, >= n
+ */
+void rs_deinterleave(const uint8_t* codeword, int n_interleave, int n, const uint8_t* seq,
+                     uint8_t* blocks, int stride);
+
+/**
+ * Inverse of rs_deinterleave() for the first len symbols of each block,
+ * out[i + j * n_interleave] = blocks[i * stride + j].
+ */
+void rs_interleave(const uint8_t* blocks, int stride, int n_interleave, int len, uint8_t* out);
+
+/**
+ * @return Name of the kernel selected for this CPU
+ */
+const char* rs_interleave_kernel();
+
+#endif /* INCLUDED_RS_INTERLEAVE_H */
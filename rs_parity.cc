@@ -0,0 +1,164 @@
+// Table driven RS parity generation on interleaved codewords
+//
+// Each codeword keeps its NROOTS byte parity shift register in vector form,
+// as in the Altivec encoder of libfec: per symbol the register is shifted by
+// one byte and the precomputed product of the feedback symbol with the
+// generator polynomial is XORed in. The n_interleave registers are advanced
+// together, one interleaved row per step. Virtual fill symbols are zero
+// and leave the registers at zero, so shortened codewords just take fewer steps.
+//
+// For dual basis codewords the register holds the dual basis representation
+// of the parity. The basis change is linear over GF(2) and commutes with
+// the byte shift, so only the feedback tables differ: they are indexed by
+// the dual basis feedback symbol and hold dual basis products.
+
+#include "rs_parity.h"
+
+#include <stdint.h>
+
+#include "ccsds.h"
+#include "rs_codec.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+template <class Codec>
+struct parity_tables
+{
+    // feedback[f][k] = f * g_(NROOTS-1-k), the term added to parity[k] after the shift
+    alignas(16) uint8_t feedback[256][Codec::NROOTS];
+    // the same rows packed into 64 bit words, byte k in bits 8*(k%8) of word k/8
+    uint64_t feedback64[256][Codec::NROOTS / 8];
+    // feedback_dual[f][k] = Taltab[feedback[Tal1tab[f]][k]], likewise packed
+    alignas(16) uint8_t feedback_dual[256][Codec::NROOTS];
+    uint64_t feedback64_dual[256][Codec::NROOTS / 8];
+};
+
+template <class Codec>
+static constexpr parity_tables<Codec> make_tables()
+{
+    constexpr auto &gf = Codec::tables;
+    parity_tables<Codec> t{};
+    for (int f = 0; f < 256; f++)
+    {
+        for (int k = 0; k < Codec::NROOTS; k++)
+        {
+            uint8_t p = 0;
+            if (f != 0)
+                p = gf.alpha_to[Codec::modnn(gf.index_of[f] + gf.genpoly[Codec::NROOTS - 1 - k])];
+            t.feedback[f][k] = p;
+            t.feedback64[f][k / 8] |= (uint64_t)p << (8 * (k % 8));
+        }
+    }
+    for (int f = 0; f < 256; f++)
+    {
+        for (int k = 0; k < Codec::NROOTS; k++)
+        {
+            uint8_t p = gf.taltab[t.feedback[gf.tal1tab[f]][k]];
+            t.feedback_dual[f][k] = p;
+            t.feedback64_dual[f][k / 8] |= (uint64_t)p << (8 * (k % 8));
+        }
+    }
+    return t;
+}
+
+template <class Codec>
+static constexpr parity_tables<Codec> s_tables = make_tables<Codec>();
+
+#ifdef __SSE2__
+// NROOTS / 16 vectors per register, shifted down by one byte with carry
+template <class Codec, int I, bool dual>
+static void parity_lanes(const uint8_t *data, uint8_t *parity, int pad)
+{
+    constexpr int NROOTS = Codec::NROOTS;
+    constexpr int C = NROOTS / 16;
+    static_assert(NROOTS % 16 == 0, "register must fill whole vectors");
+    const parity_tables<Codec> &t = s_tables<Codec>;
+    const uint8_t (*feedback)[NROOTS] = dual ? t.feedback_dual : t.feedback;
+    __m128i reg[I][C];
+    for (int l = 0; l < I; l++)
+    {
+        for (int c = 0; c < C; c++)
+            reg[l][c] = _mm_setzero_si128();
+    }
+
+    for (int j = pad; j < Codec::DATA_LEN; j++, data += I)
+    {
+        for (int l = 0; l < I; l++)
+        {
+            __m128i *r = reg[l];
+            const uint8_t *fb = feedback[(uint8_t)(data[l] ^ _mm_cvtsi128_si32(r[0]))];
+            for (int c = 0; c < C - 1; c++)
+                r[c] = _mm_or_si128(_mm_srli_si128(r[c], 1), _mm_slli_si128(r[c + 1], 15));
+            r[C - 1] = _mm_srli_si128(r[C - 1], 1);
+            for (int c = 0; c < C; c++)
+                r[c] = _mm_xor_si128(r[c], _mm_load_si128((const __m128i *)fb + c));
+        }
+    }
+
+    for (int l = 0; l < I; l++)
+    {
+        uint8_t r[NROOTS];
+        for (int c = 0; c < C; c++)
+            _mm_storeu_si128((__m128i *)r + c, reg[l][c]);
+        for (int k = 0; k < NROOTS; k++)
+            parity[l + k * I] = r[k];
+    }
+}
+#else
+// NROOTS / 8 words per register, shifted down by one byte with carry
+template <class Codec, int I, bool dual>
+static void parity_lanes(const uint8_t *data, uint8_t *parity, int pad)
+{
+    constexpr int NROOTS = Codec::NROOTS;
+    constexpr int W = NROOTS / 8;
+    static_assert(NROOTS % 8 == 0, "register must fill whole words");
+    const parity_tables<Codec> &t = s_tables<Codec>;
+    const uint64_t (*feedback64)[W] = dual ? t.feedback64_dual : t.feedback64;
+    uint64_t reg[I][W] = {{0}};
+
+    for (int j = pad; j < Codec::DATA_LEN; j++, data += I)
+    {
+        for (int l = 0; l < I; l++)
+        {
+            uint64_t *r = reg[l];
+            const uint64_t *fb = feedback64[(uint8_t)(data[l] ^ r[0])];
+            for (int w = 0; w < W - 1; w++)
+                r[w] = ((r[w] >> 8) | (r[w + 1] << 56)) ^ fb[w];
+            r[W - 1] = (r[W - 1] >> 8) ^ fb[W - 1];
+        }
+    }
+
+    for (int l = 0; l < I; l++)
+    {
+        for (int k = 0; k < NROOTS; k++)
+        {
+            parity[l + k * I] = reg[l][k / 8] >> (8 * (k % 8));
+        }
+    }
+}
+#endif
+
+typedef void (*parity_fn)(const uint8_t *, uint8_t *, int);
+
+template <class Codec>
+static const parity_fn s_parity_fns[RS_MAX_NBLOCKS][2] = {
+    {parity_lanes<Codec, 1, false>, parity_lanes<Codec, 1, true>},
+    {parity_lanes<Codec, 2, false>, parity_lanes<Codec, 2, true>},
+    {parity_lanes<Codec, 3, false>, parity_lanes<Codec, 3, true>},
+    {parity_lanes<Codec, 4, false>, parity_lanes<Codec, 4, true>},
+    {parity_lanes<Codec, 5, false>, parity_lanes<Codec, 5, true>},
+    {parity_lanes<Codec, 6, false>, parity_lanes<Codec, 6, true>},
+    {parity_lanes<Codec, 7, false>, parity_lanes<Codec, 7, true>},
+    {parity_lanes<Codec, 8, false>, parity_lanes<Codec, 8, true>},
+};
+
+template <class Codec>
+void rs_parity_interleaved(const uint8_t *data, uint8_t *parity, int n_interleave, bool use_dual_basis, int pad)
+{
+    s_parity_fns<Codec>[n_interleave - 1][use_dual_basis](data, parity, pad);
+}
+
+template void rs_parity_interleaved<rs_ccsds_e16>(const uint8_t *, uint8_t *, int, bool, int);
+template void rs_parity_interleaved<rs_ccsds_e8>(const uint8_t *, uint8_t *, int, bool, int);
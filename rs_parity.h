@@ -0,0 +1,27 @@
+#ifndef INCLUDED_RS_PARITY_H
+#define INCLUDED_RS_PARITY_H
+
+#include <stdint.h>
+
+/**
+ * Computes the parity of n_interleave codewords of Codec stored in the
+ * CCSDS interleaved layout, i.e. symbol j of codeword i is data[i + j * n_interleave].
+ *
+ * All parity shift registers advance together, one interleaved row
+ * (n_interleave symbols) per step, so neither the data nor the parity has to
+ * be gathered into contiguous blocks. n_interleave = 1 encodes a single
+ * contiguous block.
+ *
+ * Instantiated for the codes of rs_codec.h (rs_ccsds_e16, rs_ccsds_e8).
+ *
+ * @param data           (Codec::DATA_LEN - pad) * n_interleave interleaved data symbols
+ * @param parity         Output, Codec::NROOTS * n_interleave interleaved parity symbols
+ * @param n_interleave   Interleaving depth, 1..RS_MAX_NBLOCKS
+ * @param use_dual_basis Data and parity are in dual basis (CCSDS)
+ * @param pad            Virtual fill, leading zero data symbols of the
+ *                       shortened codewords that are neither stored nor processed
+ */
+template <class Codec>
+void rs_parity_interleaved(const uint8_t *data, uint8_t *parity, int n_interleave, bool use_dual_basis, int pad = 0);
+
+#endif /* INCLUDED_RS_PARITY_H */
@@ -0,0 +1,57 @@
+#include "rs_stats.h"
+
+static const char* s_stage_names[RS_NSTAGES] = {"syndrome", "berlekamp-massey", "chien", "forney"};
+
+void rs_decoder_stats::merge(const rs_decoder_stats& other)
+{
+    for (int i = 0; i < RS_NSTAGES; i++)
+    {
+        cycles[i] += other.cycles[i];
+        calls[i] += other.calls[i];
+        timed[i] += other.timed[i];
+    }
+    n_blocks += other.n_blocks;
+    for (int b = 0; b <= RS_STATS_FAILED; b++)
+    {
+        corrected[b] += other.corrected[b];
+        for (int lane = 0; lane < RS_MAX_NBLOCKS; lane++)
+        {
+            lane_corrected[lane][b] += other.lane_corrected[lane][b];
+        }
+    }
+}
+
+void rs_decoder_stats::print(FILE* out) const
+{
+    fprintf(out, "rs blocks: %llu\n", (unsigned long long)n_blocks);
+    for (int i = 0; i < RS_NSTAGES; i++)
+    {
+        fprintf(out, "  %-17s %10llu calls %10llu timed %10.1f cycles/call\n", s_stage_names[i],
+                (unsigned long long)calls[i], (unsigned long long)timed[i],
+                timed[i] ? (double)cycles[i] / timed[i] : 0.0);
+    }
+
+    int n_lanes = 0;
+    for (int lane = 0; lane < RS_MAX_NBLOCKS; lane++)
+    {
+        for (int b = 0; b <= RS_STATS_FAILED; b++)
+        {
+            if (lane_corrected[lane][b]) n_lanes = lane + 1;
+        }
+    }
+
+    fprintf(out, "  corrected symbols per block:\n");
+    for (int b = 0; b <= RS_STATS_FAILED; b++)
+    {
+        if (!corrected[b]) continue;
+        if (b == RS_STATS_FAILED)
+            fprintf(out, "    failed %10llu  lanes", (unsigned long long)corrected[b]);
+        else
+            fprintf(out, "    %6d %10llu  lanes", b, (unsigned long long)corrected[b]);
+        for (int lane = 0; lane < n_lanes; lane++)
+        {
+            fprintf(out, " %llu", (unsigned long long)lane_corrected[lane][b]);
+        }
+        fprintf(out, "\n");
+    }
+}
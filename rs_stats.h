@@ -0,0 +1,134 @@
+#ifndef INCLUDED_RS_STATS_H
+#define INCLUDED_RS_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ccsds.h"
+
+// syndromes of a clean block take little more than a few time stamp counter
+// reads, so only one call in RS_STATS_SAMPLE of that stage is timed
+#define RS_STATS_SAMPLE 16
+
+/**
+ * Optional RS decoder instrumentation, compiled in with -DRS_STATS (CMake
+ * option CCSDS_RS_STATS). Without it the RS_STATS_* macros expand to
+ * nothing and the decoders keep no statistics.
+ *
+ * The decoding stages add their time stamp counter ticks to per-thread
+ * counters; the frame decoders collect them, together with the number of
+ * symbols corrected in every RS block, into an rs_decoder_stats snapshot.
+ */
+
+enum rs_stage_t
+{
+    RS_STAGE_SYNDROME,  // syndrome computation, all blocks of a frame per call
+    RS_STAGE_BM,        // Berlekamp-Massey, erasure locator included
+    RS_STAGE_CHIEN,     // Chien search
+    RS_STAGE_FORNEY,    // error evaluator and Forney correction
+    RS_NSTAGES
+};
+
+// index of the rs_decoder_stats histograms counting uncorrectable blocks
+#define RS_STATS_FAILED (RS_PARITY_LEN + 1)
+
+struct rs_decoder_stats
+{
+    uint64_t cycles[RS_NSTAGES];   // time stamp counter ticks of the timed calls
+    uint64_t calls[RS_NSTAGES];    // times each stage ran
+    uint64_t timed[RS_NSTAGES];    // calls included in cycles
+    uint64_t n_blocks;             // RS blocks seen, clean ones included
+
+    // RS blocks by corrected symbols (0..RS_PARITY_LEN) or RS_STATS_FAILED,
+    // over all blocks and per interleave lane
+    uint64_t corrected[RS_STATS_FAILED + 1];
+    uint64_t lane_corrected[RS_MAX_NBLOCKS][RS_STATS_FAILED + 1];
+
+    inline void record(int lane, int nerrors)
+    {
+        const int bin = nerrors < 0 ? RS_STATS_FAILED : nerrors;
+        n_blocks++;
+        corrected[bin]++;
+        lane_corrected[lane][bin]++;
+    }
+
+    void merge(const rs_decoder_stats& other);
+    void print(FILE* out) const;
+};
+
+#ifdef RS_STATS
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t rs_stats_ticks() { return __rdtsc(); }
+#else
+#include <chrono>
+static inline uint64_t rs_stats_ticks()
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+#endif
+
+struct rs_stage_counters
+{
+    uint64_t cycles[RS_NSTAGES];
+    uint64_t calls[RS_NSTAGES];
+    uint64_t timed[RS_NSTAGES];
+};
+
+// stage timings of the calling thread, not yet collected by a decoder
+inline thread_local rs_stage_counters rs_thread_stage_counters = {};
+
+static inline void rs_stats_stage(int stage, uint64_t& start)
+{
+    const uint64_t now = rs_stats_ticks();
+    rs_thread_stage_counters.cycles[stage] += now - start;
+    rs_thread_stage_counters.calls[stage]++;
+    rs_thread_stage_counters.timed[stage]++;
+    start = now;
+}
+
+// starts timing one call in RS_STATS_SAMPLE of stage, 0 for the others
+static inline uint64_t rs_stats_sample_start(int stage)
+{
+    if (rs_thread_stage_counters.calls[stage]++ % RS_STATS_SAMPLE) return 0;
+    return rs_stats_ticks();
+}
+
+static inline void rs_stats_sample_end(int stage, uint64_t start)
+{
+    if (!start) return;
+    rs_thread_stage_counters.cycles[stage] += rs_stats_ticks() - start;
+    rs_thread_stage_counters.timed[stage]++;
+}
+
+// moves the stage timings of the calling thread to stats
+static inline void rs_stats_collect(rs_decoder_stats& stats)
+{
+    for (int i = 0; i < RS_NSTAGES; i++)
+    {
+        stats.cycles[i] += rs_thread_stage_counters.cycles[i];
+        stats.calls[i] += rs_thread_stage_counters.calls[i];
+        stats.timed[i] += rs_thread_stage_counters.timed[i];
+    }
+    rs_thread_stage_counters = {};
+}
+
+#define RS_STATS_START(t) uint64_t t = rs_stats_ticks()
+#define RS_STATS_STAGE(stage, t) rs_stats_stage(stage, t)
+#define RS_STATS_SAMPLE_START(stage, t) uint64_t t = rs_stats_sample_start(stage)
+#define RS_STATS_SAMPLE_END(stage, t) rs_stats_sample_end(stage, t)
+#define RS_STATS_RECORD(stats, lane, nerrors) (stats).record(lane, nerrors)
+#define RS_STATS_COLLECT(stats) rs_stats_collect(stats)
+
+#else
+
+#define RS_STATS_START(t)
+#define RS_STATS_STAGE(stage, t)
+#define RS_STATS_SAMPLE_START(stage, t)
+#define RS_STATS_SAMPLE_END(stage, t)
+#define RS_STATS_RECORD(stats, lane, nerrors)
+#define RS_STATS_COLLECT(stats)
+
+#endif /* RS_STATS */
+
+#endif /* INCLUDED_RS_STATS_H */
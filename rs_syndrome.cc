@@ -0,0 +1,274 @@
+// SIMD syndrome computation for the CCSDS Reed-Solomon codes
+//
+// The syndromes are S_i = sum_j data[j] * r_i^(N-1-j) with r_i = alpha^((FCR+i)*PRIM).
+// All NROOTS syndromes of a block are kept in vectors, one byte lane per
+// syndrome. For every received symbol d the lane constants r_i^(N-1-j) are
+// fixed, so the products d * r_i^(N-1-j) are formed with the split-nibble
+// trick: PSHUFB looks up the low and high nibble of the (precomputed) lane
+// constants in the 16 entry multiplication tables of d. For dual basis input
+// the tables of d are stored under the dual basis representation of d.
+
+#include "rs_syndrome.h"
+
+#include <stdint.h>
+
+#include "ccsds.h"
+#include "rs_codec.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RS_SYNDROME_X86 1
+#include <immintrin.h>
+#endif
+
+template <class Codec>
+struct syndrome_tables
+{
+    // mul[d][n] = d * n and mul[d][16 + n] = d * (n << 4), n = 0..15
+    alignas(32) uint8_t mul[256][32];
+    // mul_dual[d] = mul[Tal1tab[d]], the tables of dual basis symbol d
+    alignas(32) uint8_t mul_dual[256][32];
+    // low and high nibble of r_i^(N-1-j), indexed by block position j and syndrome i
+    alignas(32) uint8_t coef_lo[Codec::BLOCK_LEN][Codec::NROOTS];
+    alignas(32) uint8_t coef_hi[Codec::BLOCK_LEN][Codec::NROOTS];
+};
+
+template <class Codec>
+static constexpr syndrome_tables<Codec> make_tables()
+{
+    constexpr auto &gf = Codec::tables;
+    syndrome_tables<Codec> t{};
+
+    auto gf_mul = [&gf](int a, int b) -> uint8_t {
+        if (a == 0 || b == 0) return 0;
+        return gf.alpha_to[Codec::modnn(gf.index_of[a] + gf.index_of[b])];
+    };
+    for (int d = 0; d < 256; d++)
+    {
+        for (int n = 0; n < 16; n++)
+        {
+            t.mul[d][n] = gf_mul(d, n);
+            t.mul[d][16 + n] = gf_mul(d, n << 4);
+        }
+    }
+    for (int d = 0; d < 256; d++)
+    {
+        for (int n = 0; n < 32; n++)
+            t.mul_dual[d][n] = t.mul[gf.tal1tab[d]][n];
+    }
+    for (int j = 0; j < Codec::BLOCK_LEN; j++)
+    {
+        for (int i = 0; i < Codec::NROOTS; i++)
+        {
+            uint8_t c = gf.alpha_to[(Codec::FCR + i) * Codec::PRIM * (Codec::BLOCK_LEN - 1 - j) % Codec::NN];
+            t.coef_lo[j][i] = c & 0x0f;
+            t.coef_hi[j][i] = c >> 4;
+        }
+    }
+    return t;
+}
+
+template <class Codec>
+static constexpr syndrome_tables<Codec> s_tables = make_tables<Codec>();
+
+// Kernels evaluate I codewords stored interleaved (symbol j of codeword l at
+// data[l + j * I]) and return a bit mask of the codewords with non-zero
+// syndromes. With virtual fill the codewords start at block position pad,
+// the fill symbols are zero and contribute nothing.
+
+template <class Codec, int I, bool dual>
+static uint32_t syndromes_generic(const uint8_t *data, uint8_t (*syn)[RS_PARITY_LEN], int pad)
+{
+    constexpr int NROOTS = Codec::NROOTS;
+    const syndrome_tables<Codec> &t = s_tables<Codec>;
+    const uint8_t (*mul)[32] = dual ? t.mul_dual : t.mul;
+    uint8_t s[I][NROOTS] = {{0}};
+    for (int j = pad; j < Codec::BLOCK_LEN; j++, data += I)
+    {
+        for (int l = 0; l < I; l++)
+        {
+            const uint8_t *m = mul[data[l]];
+            for (int i = 0; i < NROOTS; i++)
+            {
+                s[l][i] ^= m[t.coef_lo[j][i]] ^ m[16 + t.coef_hi[j][i]];
+            }
+        }
+    }
+    uint32_t dirty = 0;
+    for (int l = 0; l < I; l++)
+    {
+        uint8_t any = 0;
+        for (int i = 0; i < NROOTS; i++)
+        {
+            syn[l][i] = s[l][i];
+            any |= s[l][i];
+        }
+        if (any) dirty |= 1u << l;
+    }
+    return dirty;
+}
+
+#ifdef RS_SYNDROME_X86
+// NROOTS / 16 vectors of 16 syndromes per codeword
+template <class Codec, int I, bool dual>
+__attribute__((target("ssse3")))
+static uint32_t syndromes_ssse3(const uint8_t *data, uint8_t (*syn)[RS_PARITY_LEN], int pad)
+{
+    constexpr int C = Codec::NROOTS / 16;
+    const syndrome_tables<Codec> &t = s_tables<Codec>;
+    const uint8_t (*mul)[32] = dual ? t.mul_dual : t.mul;
+    __m128i acc[I][C];
+    for (int l = 0; l < I; l++)
+    {
+        for (int c = 0; c < C; c++)
+            acc[l][c] = _mm_setzero_si128();
+    }
+    for (int j = pad; j < Codec::BLOCK_LEN; j++, data += I)
+    {
+        __m128i cl[C], ch[C];
+        for (int c = 0; c < C; c++)
+        {
+            cl[c] = _mm_load_si128((const __m128i *)t.coef_lo[j] + c);
+            ch[c] = _mm_load_si128((const __m128i *)t.coef_hi[j] + c);
+        }
+        for (int l = 0; l < I; l++)
+        {
+            const uint8_t *m = mul[data[l]];
+            const __m128i lo = _mm_load_si128((const __m128i *)m);
+            const __m128i hi = _mm_load_si128((const __m128i *)(m + 16));
+            for (int c = 0; c < C; c++)
+                acc[l][c] = _mm_xor_si128(acc[l][c], _mm_xor_si128(_mm_shuffle_epi8(lo, cl[c]), _mm_shuffle_epi8(hi, ch[c])));
+        }
+    }
+    uint32_t dirty = 0;
+    for (int l = 0; l < I; l++)
+    {
+        __m128i any = _mm_setzero_si128();
+        for (int c = 0; c < C; c++)
+        {
+            _mm_storeu_si128((__m128i *)syn[l] + c, acc[l][c]);
+            any = _mm_or_si128(any, acc[l][c]);
+        }
+        __m128i zero = _mm_cmpeq_epi8(any, _mm_setzero_si128());
+        if (_mm_movemask_epi8(zero) != 0xffff) dirty |= 1u << l;
+    }
+    return dirty;
+}
+
+// NROOTS / 32 vectors of 32 syndromes per codeword
+template <class Codec, int I, bool dual>
+__attribute__((target("avx2")))
+static uint32_t syndromes_avx2(const uint8_t *data, uint8_t (*syn)[RS_PARITY_LEN], int pad)
+{
+    constexpr int C = Codec::NROOTS / 32;
+    const syndrome_tables<Codec> &t = s_tables<Codec>;
+    const uint8_t (*mul)[32] = dual ? t.mul_dual : t.mul;
+    __m256i acc[I][C];
+    for (int l = 0; l < I; l++)
+    {
+        for (int c = 0; c < C; c++)
+            acc[l][c] = _mm256_setzero_si256();
+    }
+    for (int j = pad; j < Codec::BLOCK_LEN; j++, data += I)
+    {
+        __m256i cl[C], ch[C];
+        for (int c = 0; c < C; c++)
+        {
+            cl[c] = _mm256_load_si256((const __m256i *)t.coef_lo[j] + c);
+            ch[c] = _mm256_load_si256((const __m256i *)t.coef_hi[j] + c);
+        }
+        for (int l = 0; l < I; l++)
+        {
+            const uint8_t *m = mul[data[l]];
+            const __m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)m));
+            const __m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)(m + 16)));
+            for (int c = 0; c < C; c++)
+                acc[l][c] = _mm256_xor_si256(acc[l][c], _mm256_xor_si256(_mm256_shuffle_epi8(lo, cl[c]),
+                                                                         _mm256_shuffle_epi8(hi, ch[c])));
+        }
+    }
+    uint32_t dirty = 0;
+    for (int l = 0; l < I; l++)
+    {
+        __m256i any = _mm256_setzero_si256();
+        for (int c = 0; c < C; c++)
+        {
+            _mm256_storeu_si256((__m256i *)syn[l] + c, acc[l][c]);
+            any = _mm256_or_si256(any, acc[l][c]);
+        }
+        if (!_mm256_testz_si256(any, any)) dirty |= 1u << l;
+    }
+    return dirty;
+}
+#endif
+
+typedef uint32_t (*syndrome_fn)(const uint8_t *, uint8_t (*)[RS_PARITY_LEN], int);
+
+#define SYNDROME_FNS(kernel, Codec) { \
+    {kernel<Codec, 1, false>, kernel<Codec, 1, true>}, \
+    {kernel<Codec, 2, false>, kernel<Codec, 2, true>}, \
+    {kernel<Codec, 3, false>, kernel<Codec, 3, true>}, \
+    {kernel<Codec, 4, false>, kernel<Codec, 4, true>}, \
+    {kernel<Codec, 5, false>, kernel<Codec, 5, true>}, \
+    {kernel<Codec, 6, false>, kernel<Codec, 6, true>}, \
+    {kernel<Codec, 7, false>, kernel<Codec, 7, true>}, \
+    {kernel<Codec, 8, false>, kernel<Codec, 8, true>}, \
+}
+
+struct syndrome_kernel
+{
+    const char *name;
+    syndrome_fn fns[RS_MAX_NBLOCKS][2];
+};
+
+template <class Codec>
+static const syndrome_kernel *select_kernel()
+{
+    static_assert(Codec::NROOTS <= RS_PARITY_LEN, "syndrome rows hold RS_PARITY_LEN symbols");
+
+    static const syndrome_kernel generic = {"generic", SYNDROME_FNS(syndromes_generic, Codec)};
+#ifdef RS_SYNDROME_X86
+    __builtin_cpu_init();
+    if constexpr (Codec::NROOTS % 32 == 0)
+    {
+        static const syndrome_kernel avx2 = {"avx2", SYNDROME_FNS(syndromes_avx2, Codec)};
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return &avx2;
+        }
+    }
+    if constexpr (Codec::NROOTS % 16 == 0)
+    {
+        static const syndrome_kernel ssse3 = {"ssse3", SYNDROME_FNS(syndromes_ssse3, Codec)};
+        if (__builtin_cpu_supports("ssse3"))
+        {
+            return &ssse3;
+        }
+    }
+#endif
+    return &generic;
+}
+
+template <class Codec>
+static const syndrome_kernel &kernel()
+{
+    static const syndrome_kernel *k = select_kernel<Codec>();
+    return *k;
+}
+
+template <class Codec>
+uint32_t rs_syndromes_interleaved(const uint8_t *data, int n_interleave, uint8_t (*syn)[RS_PARITY_LEN],
+                                  bool use_dual_basis, int pad)
+{
+    return kernel<Codec>().fns[n_interleave - 1][use_dual_basis](data, syn, pad);
+}
+
+template <class Codec>
+const char *rs_syndrome_kernel()
+{
+    return kernel<Codec>().name;
+}
+
+template uint32_t rs_syndromes_interleaved<rs_ccsds_e16>(const uint8_t *, int, uint8_t (*)[RS_PARITY_LEN], bool, int);
+template uint32_t rs_syndromes_interleaved<rs_ccsds_e8>(const uint8_t *, int, uint8_t (*)[RS_PARITY_LEN], bool, int);
+template const char *rs_syndrome_kernel<rs_ccsds_e16>();
+template const char *rs_syndrome_kernel<rs_ccsds_e8>();
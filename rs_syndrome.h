@@ -0,0 +1,38 @@
+#ifndef INCLUDED_RS_SYNDROME_H
+#define INCLUDED_RS_SYNDROME_H
+
+#include <stdint.h>
+#include "ccsds.h"
+
+/**
+ * Computes the Codec::NROOTS syndromes of n_interleave RS blocks stored in
+ * the CCSDS interleaved layout (symbol j of block i at data[i + j * n_interleave])
+ * in a single pass over the buffer, i.e. evaluates every received polynomial
+ * at the roots of the generator.
+ *
+ * The syndromes are written in poly-form and refer to the conventional
+ * basis, so they can be passed straight to Codec::decode() and
+ * Codec::decode_dual(). The kernel (AVX2, SSSE3 or portable C) is chosen
+ * once at runtime from the CPU features.
+ *
+ * Instantiated for the codes of rs_codec.h (rs_ccsds_e16, rs_ccsds_e8).
+ *
+ * @param data           (Codec::BLOCK_LEN - pad) * n_interleave interleaved symbols
+ * @param n_interleave   Interleaving depth, 1..RS_MAX_NBLOCKS
+ * @param syn            Output, Codec::NROOTS syndromes per block
+ * @param use_dual_basis Treat the input symbols as dual basis (CCSDS)
+ * @param pad            Virtual fill, leading zero symbols of the shortened
+ *                       blocks that are neither stored nor processed
+ * @return               Bit mask of the blocks with non-zero syndromes
+ */
+template <class Codec>
+uint32_t rs_syndromes_interleaved(const uint8_t *data, int n_interleave, uint8_t (*syn)[RS_PARITY_LEN],
+                                  bool use_dual_basis, int pad = 0);
+
+/**
+ * @return Name of the syndrome kernel selected for this CPU and code
+ */
+template <class Codec>
+const char *rs_syndrome_kernel();
+
+#endif /* INCLUDED_RS_SYNDROME_H */
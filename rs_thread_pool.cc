@@ -0,0 +1,122 @@
+#include "rs_thread_pool.h"
+
+#include <algorithm>
+
+// index of the worker running on this thread, -1 on other threads
+static thread_local int s_worker_index = -1;
+static thread_local const rs_thread_pool* s_worker_pool = nullptr;
+
+rs_thread_pool::rs_thread_pool(int n_threads)
+{
+    if (n_threads <= 0)
+    {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < n_threads; i++)
+    {
+        d_workers.emplace_back(new worker);
+    }
+    for (int i = 0; i < n_threads; i++)
+    {
+        d_workers[i]->thread = std::thread(&rs_thread_pool::run, this, i);
+    }
+}
+
+rs_thread_pool::~rs_thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_stop = true;
+    }
+    d_work_cv.notify_all();
+    for (auto& w : d_workers)
+    {
+        w->thread.join();
+    }
+}
+
+void rs_thread_pool::submit(task_t task)
+{
+    int index;
+    if (s_worker_pool == this)
+    {
+        index = s_worker_index;
+    }
+    else
+    {
+        index = d_next.fetch_add(1, std::memory_order_relaxed) % d_workers.size();
+    }
+
+    d_pending.fetch_add(1);
+    d_queued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(d_workers[index]->mutex);
+        d_workers[index]->tasks.push_back(std::move(task));
+    }
+
+    // taking the lock orders the notification after a worker's predicate check
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+    }
+    d_work_cv.notify_one();
+}
+
+void rs_thread_pool::wait()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    d_done_cv.wait(lock, [this] { return d_pending.load() == 0; });
+}
+
+bool rs_thread_pool::pop(int index, task_t& task)
+{
+    worker& w = *d_workers[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) return false;
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool rs_thread_pool::steal(int index, task_t& task)
+{
+    const int n = (int)d_workers.size();
+    for (int k = 1; k < n; k++)
+    {
+        worker& victim = *d_workers[(index + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void rs_thread_pool::run(int index)
+{
+    s_worker_index = index;
+    s_worker_pool = this;
+
+    task_t task;
+    while (true)
+    {
+        if (pop(index, task) || steal(index, task))
+        {
+            d_queued.fetch_sub(1);
+            task();
+            task = nullptr;
+            if (d_pending.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(d_mutex);
+                d_done_cv.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(d_mutex);
+        d_work_cv.wait(lock, [this] { return d_stop || d_queued.load() > 0; });
+        if (d_stop && d_queued.load() == 0) return;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef INCLUDED_RS_THREAD_POOL_H
+#define INCLUDED_RS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool for the RS decode tasks.
+ *
+ * Every worker owns a task deque. Tasks submitted from a worker (e.g. the
+ * per-codeword tasks spawned by a per-frame task) go to the back of its own
+ * deque and are run LIFO, keeping the frame data hot in its cache; idle
+ * workers steal from the front of the other deques, so a few slow (noisy)
+ * codewords never hold up the rest of a batch.
+ */
+class rs_thread_pool
+{
+public:
+    typedef std::function<void()> task_t;
+
+    /**
+     * @param n_threads Number of workers, 0 for one per hardware thread
+     */
+    explicit rs_thread_pool(int n_threads = 0);
+    ~rs_thread_pool();
+
+    rs_thread_pool(const rs_thread_pool&) = delete;
+    rs_thread_pool& operator=(const rs_thread_pool&) = delete;
+
+    int size() const { return (int)d_workers.size(); }
+
+    /**
+     * Queues a task. Safe to call from inside a running task.
+     */
+    void submit(task_t task);
+
+    /**
+     * Blocks until every submitted task, including the ones submitted by
+     * tasks, has finished. Must not be called from a task.
+     */
+    void wait();
+
+private:
+    struct worker
+    {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+        std::thread thread;
+    };
+
+    void run(int index);
+    bool pop(int index, task_t& task);
+    bool steal(int index, task_t& task);
+
+    std::vector<std::unique_ptr<worker>> d_workers;
+
+    std::mutex d_mutex;
+    std::condition_variable d_work_cv;
+    std::condition_variable d_done_cv;
+    std::atomic<int> d_queued{0};  // tasks waiting in the deques
+    std::atomic<int> d_pending{0}; // tasks submitted and not finished
+    std::atomic<unsigned> d_next{0};
+    bool d_stop = false;
+};
+
+#endif /* INCLUDED_RS_THREAD_POOL_H */
@@ -0,0 +1,107 @@
+#include "soft_sync.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef size_t (*find_sync_soft_fn)(const int8_t *, size_t, size_t, const soft_sync_pattern &, float, float *);
+
+void make_soft_sync_pattern(uint64_t sync_word, uint64_t mask, soft_sync_pattern *pattern)
+{
+    memset(pattern->taps, 0, sizeof(pattern->taps));
+    pattern->len = 64 - __builtin_clzll(mask);
+    pattern->n_taps = __builtin_popcountll(mask);
+    for (int i = 0; i < pattern->len; i++)
+    {
+        const int bit = pattern->len - 1 - i;
+        if ((mask >> bit) & 1)
+        {
+            pattern->taps[i] = (sync_word >> bit) & 1 ? 1 : -1;
+        }
+    }
+}
+
+static inline bool soft_sync_match(int dot, int magnitude, float threshold, float *correlation)
+{
+    if (dot == 0 || fabsf((float)dot) < threshold * magnitude) return false;
+    *correlation = (float)dot / magnitude;
+    return true;
+}
+
+static size_t find_sync_soft_generic(const int8_t *in, size_t w, size_t n_windows, const soft_sync_pattern &pattern,
+                                     float threshold, float *correlation)
+{
+    for (; w < n_windows; w++)
+    {
+        int dot = 0;
+        int magnitude = 0;
+        for (int i = 0; i < pattern.len; i++)
+        {
+            const int y = pattern.taps[i] * in[w + i];
+            dot += y;
+            magnitude += y < 0 ? -y : y;
+        }
+        if (soft_sync_match(dot, magnitude, threshold, correlation)) return w;
+    }
+    return n_windows;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SOFT_SYNC_X86
+#include <immintrin.h>
+
+// One window of up to 32 (64) symbols per one (two) vectors: PSIGNB applies
+// the taps, PMADDUBSW and PMADDWD against ones sum the products and their
+// magnitudes, and both sums are reduced together.
+__attribute__((target("avx2")))
+static size_t find_sync_soft_avx2(const int8_t *in, size_t w, size_t n_windows, const soft_sync_pattern &pattern,
+                                  float threshold, float *correlation)
+{
+    const int n_vec = pattern.len > 32 ? 2 : 1;
+    const __m256i taps[2] = {_mm256_loadu_si256((const __m256i *)&pattern.taps[0]),
+                             _mm256_loadu_si256((const __m256i *)&pattern.taps[32])};
+    const __m256i ones8 = _mm256_set1_epi8(1);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+
+    // the vectors of the last windows would read past the input
+    const size_t n_symbols = n_windows + pattern.len - 1;
+    for (; w + 32 * n_vec <= n_symbols; w++)
+    {
+        __m256i dot = _mm256_setzero_si256();
+        __m256i magnitude = _mm256_setzero_si256();
+        for (int v = 0; v < n_vec; v++)
+        {
+            const __m256i y = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i *)&in[w + 32 * v]), taps[v]);
+            dot = _mm256_add_epi32(dot, _mm256_madd_epi16(_mm256_maddubs_epi16(ones8, y), ones16));
+            magnitude = _mm256_add_epi32(
+                magnitude, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_abs_epi8(y), ones8), ones16));
+        }
+        const __m256i sums = _mm256_hadd_epi32(dot, magnitude);
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        s = _mm_hadd_epi32(s, s);
+        if (soft_sync_match(_mm_cvtsi128_si32(s), _mm_extract_epi32(s, 1), threshold, correlation))
+        {
+            return w;
+        }
+    }
+    return find_sync_soft_generic(in, w, n_windows, pattern, threshold, correlation);
+}
+#endif
+
+static find_sync_soft_fn select_find_sync_soft()
+{
+#ifdef SOFT_SYNC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return find_sync_soft_avx2;
+    }
+#endif
+    return find_sync_soft_generic;
+}
+
+size_t find_sync_soft(const int8_t *in, size_t n_windows, const soft_sync_pattern &pattern, float threshold,
+                      float *correlation)
+{
+    static const find_sync_soft_fn find_sync = select_find_sync_soft();
+    return find_sync(in, 0, n_windows, pattern, threshold, correlation);
+}
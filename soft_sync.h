@@ -0,0 +1,59 @@
+#ifndef INCLUDED_SOFT_SYNC_H
+#define INCLUDED_SOFT_SYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Soft-decision sync word correlation. Soft symbols are int8 LLR-like
+// values, positive for a 1 bit, in -127..127. The 0..255 soft bytes of the
+// Viterbi decoder input (0 a certain 0, 255 a certain 1, 128 an erasure)
+// map to them by subtracting 128.
+
+#define SOFT_SYNC_MAX_LEN 64
+
+struct soft_sync_pattern
+{
+    int8_t taps[SOFT_SYNC_MAX_LEN];  // +1 / -1 per sync word bit 1 / 0, first bit first, 0 where masked out
+    int len;                          // sync word length in symbols
+    int n_taps;                       // non-zero taps
+};
+
+inline int8_t soft_symbol(int8_t llr)
+{
+    return llr == -128 ? -127 : llr;
+}
+
+inline int8_t soft_symbol(uint8_t soft)
+{
+    return soft_symbol((int8_t)(soft ^ 0x80));
+}
+
+/**
+ * Builds the correlation pattern of a sync word of up to 64 bits, compared
+ * where mask (non-zero) is set.
+ */
+void make_soft_sync_pattern(uint64_t sync_word, uint64_t mask, soft_sync_pattern *pattern);
+
+/**
+ * Correlates the pattern with the windows in[w..w + len) of soft symbols,
+ * w = 0..n_windows - 1, and stops at the first one whose normalized
+ * correlation
+ *
+ *   rho = sum(taps[i] * in[w + i]) / sum(|taps[i] * in[w + i]|)
+ *
+ * reaches threshold in magnitude. rho is 1 - 2 * (sum of the magnitudes of
+ * the symbols disagreeing with the sync word) / (sum of all magnitudes), a
+ * soft Hamming distance (the high SNR form of Massey's optimum sync rule)
+ * that doesn't depend on the amplitude of the symbols: 1 for the sync word,
+ * -1 for its complement (BPSK phase ambiguity) and 1 - 2 * errors / n_taps
+ * for hard decisions. The dot products run in AVX2 when the CPU has it.
+ *
+ * @param in          n_windows + len - 1 soft symbols, see soft_symbol()
+ * @param threshold   Minimum |rho|, 0 < threshold <= 1
+ * @param correlation Output, rho of the window found
+ * @return            Index of the window found, or n_windows
+ */
+size_t find_sync_soft(const int8_t *in, size_t n_windows, const soft_sync_pattern &pattern, float threshold,
+                      float *correlation);
+
+#endif /* INCLUDED_SOFT_SYNC_H */
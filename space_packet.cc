@@ -0,0 +1,169 @@
+// Space Packet extraction from transfer frames
+
+#include "space_packet.h"
+
+#include <string.h>
+
+#define SLAB_MIN_BYTES (64 * 1024)
+
+static size_t packet_len(const uint8_t* header)
+{
+    return SP_PRIMARY_HEADER_LEN + (((size_t)header[4] << 8) | header[5]) + 1;
+}
+
+packet_pool::~packet_pool()
+{
+    for (uint8_t* slab : d_slabs) delete[] slab;
+}
+
+uint8_t* packet_pool::alloc(size_t len)
+{
+    int c = 0;
+    while (c < N_CLASSES - 1 && (size_t)256 << c < len) c++;
+
+    if (!d_free[c])
+    {
+        // a new slab of blocks of this class
+        const size_t block = sizeof(block_header) + ((size_t)256 << c);
+        const size_t n_blocks = block >= SLAB_MIN_BYTES ? 1 : SLAB_MIN_BYTES / block;
+        uint8_t* slab = new uint8_t[n_blocks * block];
+        d_slabs.push_back(slab);
+        d_slab_bytes += n_blocks * block;
+        for (size_t i = 0; i < n_blocks; i++)
+        {
+            block_header* h = (block_header*)&slab[i * block];
+            h->size_class = c;
+            h->next = d_free[c];
+            d_free[c] = h;
+        }
+    }
+
+    block_header* h = d_free[c];
+    d_free[c] = h->next;
+    d_in_use++;
+    return (uint8_t*)(h + 1);
+}
+
+void packet_pool::release(uint8_t* block)
+{
+    block_header* h = (block_header*)block - 1;
+    h->next = d_free[h->size_class];
+    d_free[h->size_class] = h;
+    d_in_use--;
+}
+
+packet_extractor::packet_extractor(packet_pool* pool)
+    : d_own_pool(pool ? nullptr : new packet_pool), d_pool(pool ? pool : d_own_pool.get())
+{
+}
+
+packet_extractor::~packet_extractor()
+{
+    reset();
+}
+
+void packet_extractor::reset()
+{
+    if (d_block) d_pool->release(d_block);
+    if (d_have) d_counters.dropped++;
+    d_block = nullptr;
+    d_have = 0;
+    d_need = 0;
+}
+
+void packet_extractor::release(const space_packet& packet)
+{
+    if (packet.pooled) d_pool->release((uint8_t*)packet.data);
+}
+
+void packet_extractor::emit(const uint8_t* data, uint32_t len, bool pooled, std::vector<space_packet>* packets)
+{
+    if ((((data[0] & 0x07) << 8) | data[1]) == SP_IDLE_APID)
+    {
+        d_counters.idle++;
+        if (pooled) d_pool->release((uint8_t*)data);
+        return;
+    }
+    (pooled ? d_counters.reassembled : d_counters.packets)++;
+    packets->push_back({data, len, pooled});
+}
+
+// adds up to len bytes to the packet in progress, returns how many it took
+size_t packet_extractor::continue_packet(const uint8_t* zone, size_t len, std::vector<space_packet>* packets)
+{
+    size_t used = 0;
+    if (d_need == 0)
+    {
+        // the header is split across frames
+        used = SP_PRIMARY_HEADER_LEN - d_have < len ? SP_PRIMARY_HEADER_LEN - d_have : len;
+        memcpy(&d_header[d_have], zone, used);
+        d_have += used;
+        if (d_have < SP_PRIMARY_HEADER_LEN) return used;
+        d_need = packet_len(d_header);
+        d_block = d_pool->alloc(d_need);
+        memcpy(d_block, d_header, SP_PRIMARY_HEADER_LEN);
+    }
+
+    const size_t n = d_need - d_have < len - used ? d_need - d_have : len - used;
+    memcpy(&d_block[d_have], &zone[used], n);
+    d_have += n;
+    used += n;
+    if (d_have == d_need)
+    {
+        emit(d_block, d_need, true, packets);
+        d_block = nullptr;
+        d_have = 0;
+        d_need = 0;
+    }
+    return used;
+}
+
+int packet_extractor::extract(const transfer_frame_view& frame, std::vector<space_packet>* packets)
+{
+    const size_t n_before = packets->size();
+    // frames without packet service (TM synchronous data, AOS bitstream)
+    if (frame.sync_flag() || (frame.type == TF_AOS && !frame.has_m_pdu)) return 0;
+
+    const uint8_t* zone = frame.packet_zone();
+    const size_t len = frame.packet_zone_len();
+    const uint16_t fhp = frame.first_header_pointer();
+    const uint32_t count = frame.vc_count();
+
+    // a packet in progress doesn't survive a lost frame, the next one
+    // starts at the first header pointer
+    if (d_seen && count != d_next_count)
+    {
+        reset();
+        d_counters.gaps++;
+    }
+    d_seen = true;
+    d_next_count = (count + 1) & (frame.vc_count_modulus() - 1);
+
+    if (d_have > 0)
+    {
+        // the packet in progress ends where the next one starts
+        const size_t end = continue_packet(zone, fhp < len ? fhp : len, packets);
+        if (fhp == TF_FHP_NO_PACKET) return packets->size() - n_before;
+        if (d_have > 0 || end != fhp) reset();
+    }
+    if (fhp >= len) return packets->size() - n_before;
+
+    size_t pos = fhp;
+    while (pos < len)
+    {
+        const size_t left = len - pos;
+        if (left >= SP_PRIMARY_HEADER_LEN)
+        {
+            const size_t n = packet_len(&zone[pos]);
+            if (n <= left)
+            {
+                emit(&zone[pos], n, false, packets);
+                pos += n;
+                continue;
+            }
+        }
+        // starts a packet that continues in the next frame
+        pos += continue_packet(&zone[pos], left, packets);
+    }
+    return packets->size() - n_before;
+}
@@ -0,0 +1,159 @@
+#ifndef INCLUDED_SPACE_PACKET_H
+#define INCLUDED_SPACE_PACKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include "transfer_frame.h"
+
+/*
+ * CCSDS Space Packets (133.0-B) carried by the packet zones of transfer
+ * frames. The primary header:
+ *
+ *   version:3 type:1 secondary header flag:1 APID:11 |
+ *   sequence flags:2 sequence count:14 | data length:16 (data field - 1)
+ */
+
+#define SP_PRIMARY_HEADER_LEN 6
+#define SP_MAX_LEN (SP_PRIMARY_HEADER_LEN + 65536)
+#define SP_IDLE_APID 0x7ff
+
+/**
+ * Buffers for the packets reassembled across frames. Blocks come in power
+ * of two size classes from 256 bytes to SP_MAX_LEN and are cut from slabs
+ * of at least 64 KiB; released blocks go to the free list of their class
+ * and are reused, so once the pool has grown to the largest number of
+ * packets in flight nothing is allocated. Not thread safe.
+ */
+class packet_pool
+{
+public:
+    packet_pool() = default;
+    ~packet_pool();
+
+    packet_pool(const packet_pool&) = delete;
+    packet_pool& operator=(const packet_pool&) = delete;
+
+    /**
+     * @return A block of at least len (<= SP_MAX_LEN) bytes
+     */
+    uint8_t* alloc(size_t len);
+
+    /**
+     * Returns a block of alloc() to the pool.
+     */
+    void release(uint8_t* block);
+
+    size_t slab_bytes() const { return d_slab_bytes; }
+    size_t blocks_in_use() const { return d_in_use; }
+
+private:
+    static const int N_CLASSES = 10;  // 256 << 9 >= SP_MAX_LEN
+
+    struct block_header
+    {
+        block_header* next;  // free list
+        int size_class;
+        int pad;             // keeps the block 16-byte aligned
+    };
+
+    std::vector<uint8_t*> d_slabs;
+    block_header* d_free[N_CLASSES] = {};
+    size_t d_slab_bytes = 0;
+    size_t d_in_use = 0;
+};
+
+/**
+ * A Space Packet, header included, either in place in its transfer frame
+ * or in a packet_pool block if it spans frames.
+ */
+struct space_packet
+{
+    const uint8_t* data;
+    uint32_t len;
+    bool pooled;  // data is a packet_pool block, see packet_extractor::release()
+
+    int version() const { return data[0] >> 5; }
+    int type() const { return (data[0] >> 4) & 0x1; }
+    bool secondary_header() const { return data[0] & 0x08; }
+    int apid() const { return ((data[0] & 0x07) << 8) | data[1]; }
+    int sequence_flags() const { return data[2] >> 6; }
+    int sequence_count() const { return ((data[2] & 0x3f) << 8) | data[3]; }
+    const uint8_t* data_field() const { return &data[SP_PRIMARY_HEADER_LEN]; }
+    size_t data_field_len() const { return len - SP_PRIMARY_HEADER_LEN; }
+};
+
+/**
+ * Extracts the Space Packets of one virtual channel from its frames, in
+ * order (e.g. the frames vc_demux::pop() returns for the VC). The first
+ * header pointer of each frame is used to find the packet boundaries: to
+ * synchronize at the first packet that starts in a frame, after a gap in
+ * the VC frame count, and to check the packet in progress ends where the
+ * frame says. A packet that is wholly in one frame is returned as a view
+ * into the frame, valid as long as the frame; one that spans frames is
+ * copied piece by piece into a packet_pool block, valid until release().
+ * Idle packets are dropped. No allocation per packet once the pool and the
+ * output vector have grown.
+ */
+class packet_extractor
+{
+public:
+    struct counters_t
+    {
+        uint64_t packets;      // returned in place
+        uint64_t reassembled;  // returned from the pool
+        uint64_t idle;         // idle packets dropped
+        uint64_t dropped;      // partial packets lost to gaps or FHP mismatches
+        uint64_t gaps;         // VC frame count discontinuities
+    };
+
+    /**
+     * @param pool Buffers of the packets that span frames, may be shared
+     *             by the extractors of one thread, nullptr for a pool of
+     *             this extractor's own. Must outlive the extractor.
+     */
+    explicit packet_extractor(packet_pool* pool = nullptr);
+    ~packet_extractor();
+
+    packet_extractor(const packet_extractor&) = delete;
+    packet_extractor& operator=(const packet_extractor&) = delete;
+
+    /**
+     * Appends the packets completed by frame to packets.
+     *
+     * @return Number of packets appended
+     */
+    int extract(const transfer_frame_view& frame, std::vector<space_packet>* packets);
+
+    /**
+     * Returns the block of a pooled packet, no-op for one in place.
+     */
+    void release(const space_packet& packet);
+
+    /**
+     * Drops the packet in progress, e.g. when the VC restarts.
+     */
+    void reset();
+
+    const counters_t& counters() const { return d_counters; }
+
+private:
+    size_t continue_packet(const uint8_t* zone, size_t len, std::vector<space_packet>* packets);
+    void emit(const uint8_t* data, uint32_t len, bool pooled, std::vector<space_packet>* packets);
+
+    std::unique_ptr<packet_pool> d_own_pool;
+    packet_pool* d_pool;
+
+    // packet in progress: its header while incomplete, then its block
+    uint8_t d_header[SP_PRIMARY_HEADER_LEN];
+    uint8_t* d_block = nullptr;
+    size_t d_have = 0;    // bytes of the packet so far, 0 if none in progress
+    size_t d_need = 0;    // its length, 0 while the header is incomplete
+
+    bool d_seen = false;
+    uint32_t d_next_count = 0;
+    counters_t d_counters = {};
+};
+
+#endif /* INCLUDED_SPACE_PACKET_H */
@@ -0,0 +1,275 @@
+#include "stream_pipeline.h"
+
+#include <chrono>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define cpu_relax() _mm_pause()
+#else
+#define cpu_relax() do {} while (0)
+#endif
+
+typedef std::chrono::steady_clock pipeline_clock;
+
+static uint64_t elapsed_ns(pipeline_clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(pipeline_clock::now() - since).count();
+}
+
+// spins, then yields, then sleeps, so that idle nodes soon leave the core
+// to the busy ones
+static void backoff(int* n_waits)
+{
+    if (*n_waits < 64)
+        cpu_relax();
+    else if (*n_waits < 128)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    (*n_waits)++;
+}
+
+stream_pipeline::stream_pipeline(int queue_depth, size_t batch_size)
+    : d_queue_depth(queue_depth), d_batch_size(batch_size)
+{
+}
+
+stream_pipeline::~stream_pipeline()
+{
+    stop();
+}
+
+void stream_pipeline::set_source(const char* name, source_fn source)
+{
+    node* n = new node;
+    n->name = name;
+    n->kind = SOURCE;
+    n->source = std::move(source);
+    d_nodes.emplace_back(n);
+}
+
+void stream_pipeline::add_stage(const char* name, stage_fn stage, finish_fn finish)
+{
+    node* n = new node;
+    n->name = name;
+    n->kind = STAGE;
+    n->stage = std::move(stage);
+    n->finish = std::move(finish);
+    d_nodes.emplace_back(n);
+}
+
+void stream_pipeline::set_sink(const char* name, sink_fn sink)
+{
+    node* n = new node;
+    n->name = name;
+    n->kind = SINK;
+    n->sink = std::move(sink);
+    d_nodes.emplace_back(n);
+}
+
+void stream_pipeline::start()
+{
+    if (d_running || d_nodes.size() < 2 || d_nodes.front()->kind != SOURCE || d_nodes.back()->kind != SINK)
+    {
+        fprintf(stderr, "stream_pipeline: needs a source, stages and a sink, in this order\n");
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < d_nodes.size(); i++)
+    {
+        link* l = new link(d_queue_depth);
+        for (int b = 0; b < d_queue_depth; b++)
+        {
+            l->batches.emplace_back(new stream_batch);
+            l->batches.back()->buffer.resize(d_batch_size);
+            l->empty.push(l->batches.back().get());
+        }
+        d_links.emplace_back(l);
+        d_nodes[i]->out = l;
+        d_nodes[i + 1]->in = l;
+    }
+
+    d_stop = false;
+    d_running = true;
+    for (auto& n : d_nodes)
+    {
+        n->thread = std::thread(&stream_pipeline::run, this, n.get());
+    }
+}
+
+void stream_pipeline::wait()
+{
+    for (auto& n : d_nodes)
+    {
+        if (n->thread.joinable()) n->thread.join();
+    }
+    d_running = false;
+}
+
+void stream_pipeline::stop()
+{
+    d_stop = true;
+    wait();
+}
+
+// the next full batch of the input queue, false once the producer is done
+// and the queue is drained (or on stop())
+bool stream_pipeline::take_input(node* n, stream_batch** batch)
+{
+    const pipeline_clock::time_point start = pipeline_clock::now();
+    int n_waits = 0;
+    bool ok;
+    while (!(ok = n->in->full.pop(batch)))
+    {
+        if (d_stop.load(std::memory_order_relaxed)) break;
+        if (n->in->closed.load(std::memory_order_acquire))
+        {
+            // whatever was pushed before the queue was closed
+            ok = n->in->full.pop(batch);
+            break;
+        }
+        backoff(&n_waits);
+    }
+    if (n_waits) n->starved_ns.fetch_add(elapsed_ns(start), std::memory_order_relaxed);
+    if (!ok) return false;
+
+    const size_t depth = n->in->full.size() + 1;
+    n->depth_sum.fetch_add(depth, std::memory_order_relaxed);
+    if (depth > n->max_depth.load(std::memory_order_relaxed)) n->max_depth.store(depth, std::memory_order_relaxed);
+    n->bytes_in.fetch_add((*batch)->len, std::memory_order_relaxed);
+    return true;
+}
+
+// an empty batch of the output queue, false on stop()
+bool stream_pipeline::take_output(node* n, stream_batch** batch)
+{
+    const pipeline_clock::time_point start = pipeline_clock::now();
+    int n_waits = 0;
+    bool ok;
+    while (!(ok = n->out->empty.pop(batch)) && !d_stop.load(std::memory_order_relaxed))
+    {
+        backoff(&n_waits);
+    }
+    if (n_waits)
+    {
+        n->blocked.fetch_add(1, std::memory_order_relaxed);
+        n->blocked_ns.fetch_add(elapsed_ns(start), std::memory_order_relaxed);
+    }
+    if (!ok) return false;
+
+    (*batch)->len = 0;
+    (*batch)->n_items = 0;
+    return true;
+}
+
+void stream_pipeline::run(node* n)
+{
+    uint64_t seq = 0;
+    for (;;)
+    {
+        stream_batch* in = nullptr;
+        stream_batch* out = nullptr;
+        if (n->in && !take_input(n, &in)) break;
+        if (n->out && !take_output(n, &out))
+        {
+            if (in) n->in->empty.push(in);
+            break;
+        }
+
+        const pipeline_clock::time_point start = pipeline_clock::now();
+        bool more = true;
+        switch (n->kind)
+        {
+            case SOURCE:
+            {
+                out->seq = seq++;
+                more = n->source(out);
+                break;
+            }
+            case STAGE:
+            {
+                out->seq = seq = in->seq;
+                n->stage(*in, out);
+                break;
+            }
+            case SINK:
+            {
+                n->sink(*in);
+                break;
+            }
+        }
+        n->busy_ns.fetch_add(elapsed_ns(start), std::memory_order_relaxed);
+
+        // the queues hold all batches of their link, these never fail
+        if (in) n->in->empty.push(in);
+        if (out)
+        {
+            if (!more)
+            {
+                n->out->empty.push(out);
+                break;
+            }
+            n->out->full.push(out);
+            n->bytes_out.fetch_add(out->len, std::memory_order_relaxed);
+            n->items_out.fetch_add(out->n_items, std::memory_order_relaxed);
+        }
+        n->batches.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (n->finish && !d_stop.load(std::memory_order_relaxed)) finish(n, seq);
+    if (n->out) n->out->closed.store(true, std::memory_order_release);
+}
+
+// the input of the stage has ended, its finish function fills one more batch
+void stream_pipeline::finish(node* n, uint64_t seq)
+{
+    stream_batch* out = nullptr;
+    if (!take_output(n, &out)) return;
+
+    const pipeline_clock::time_point start = pipeline_clock::now();
+    out->seq = seq;
+    n->finish(out);
+    n->busy_ns.fetch_add(elapsed_ns(start), std::memory_order_relaxed);
+
+    if (out->len == 0 && out->n_items == 0)
+    {
+        n->out->empty.push(out);
+        return;
+    }
+    n->out->full.push(out);
+    n->bytes_out.fetch_add(out->len, std::memory_order_relaxed);
+    n->items_out.fetch_add(out->n_items, std::memory_order_relaxed);
+}
+
+std::vector<stream_pipeline::stage_metrics> stream_pipeline::metrics() const
+{
+    std::vector<stage_metrics> metrics;
+    for (const auto& n : d_nodes)
+    {
+        stage_metrics m;
+        m.name = n->name;
+        m.batches = n->batches.load(std::memory_order_relaxed);
+        m.bytes_in = n->bytes_in.load(std::memory_order_relaxed);
+        m.bytes_out = n->bytes_out.load(std::memory_order_relaxed);
+        m.items_out = n->items_out.load(std::memory_order_relaxed);
+        m.busy_s = n->busy_ns.load(std::memory_order_relaxed) * 1e-9;
+        m.starved_s = n->starved_ns.load(std::memory_order_relaxed) * 1e-9;
+        m.blocked_s = n->blocked_ns.load(std::memory_order_relaxed) * 1e-9;
+        m.blocked = n->blocked.load(std::memory_order_relaxed);
+        m.max_depth = n->max_depth.load(std::memory_order_relaxed);
+        m.mean_depth = m.batches ? (double)n->depth_sum.load(std::memory_order_relaxed) / m.batches : 0.0;
+        metrics.push_back(m);
+    }
+    return metrics;
+}
+
+void stream_pipeline::print_metrics(FILE* out) const
+{
+    fprintf(out, "  %-12s %9s %10s %10s %9s %9s %9s %8s %6s\n", "stage", "batches", "MB in", "MB out", "busy s",
+            "starved s", "blocked s", "blocked", "depth");
+    for (const stage_metrics& m : metrics())
+    {
+        fprintf(out, "  %-12s %9llu %10.1f %10.1f %9.3f %9.3f %9.3f %8llu %2.1f/%zu\n", m.name.c_str(),
+                (unsigned long long)m.batches, m.bytes_in / 1e6, m.bytes_out / 1e6, m.busy_s, m.starved_s, m.blocked_s,
+                (unsigned long long)m.blocked, m.mean_depth, m.max_depth);
+    }
+}
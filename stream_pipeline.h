@@ -0,0 +1,216 @@
+#ifndef INCLUDED_STREAM_PIPELINE_H
+#define INCLUDED_STREAM_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Bounded lock-free queue between one producer and one consumer thread.
+ */
+template <class T>
+class spsc_queue
+{
+public:
+    explicit spsc_queue(size_t capacity) : d_capacity(capacity), d_items(capacity) {}
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    /**
+     * Producer: false if the queue is full.
+     */
+    bool push(const T& item)
+    {
+        const uint64_t head = d_head.load(std::memory_order_relaxed);
+        if (head - d_tail.load(std::memory_order_acquire) == d_capacity) return false;
+        d_items[head % d_capacity] = item;
+        d_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer: false if the queue is empty.
+     */
+    bool pop(T* item)
+    {
+        const uint64_t tail = d_tail.load(std::memory_order_relaxed);
+        if (tail == d_head.load(std::memory_order_acquire)) return false;
+        *item = d_items[tail % d_capacity];
+        d_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const { return d_head.load(std::memory_order_acquire) - d_tail.load(std::memory_order_acquire); }
+    size_t capacity() const { return d_capacity; }
+
+private:
+    size_t d_capacity;
+    std::vector<T> d_items;
+
+    // items pushed and popped, on separate cache lines
+    alignas(64) std::atomic<uint64_t> d_head{0};
+    alignas(64) std::atomic<uint64_t> d_tail{0};
+};
+
+/**
+ * A batch of data passed between two pipeline nodes. Batches are allocated
+ * once per queue slot and recycled, their buffer keeps its size between
+ * uses.
+ */
+struct stream_batch
+{
+    std::vector<uint8_t> buffer;
+    size_t len = 0;        // bytes of data in buffer
+    uint32_t n_items = 0;  // e.g. frames, as defined by the producing stage
+    uint64_t seq = 0;      // number of the source batch it derives from
+
+    uint8_t* data() { return buffer.data(); }
+    const uint8_t* data() const { return buffer.data(); }
+
+    /**
+     * Makes room for n more bytes of data.
+     *
+     * @return Pointer to the first of them (data() + len)
+     */
+    uint8_t* grow(size_t n)
+    {
+        if (len + n > buffer.size()) buffer.resize(len + n > 2 * buffer.size() ? len + n : 2 * buffer.size());
+        return buffer.data() + len;
+    }
+};
+
+/**
+ * Streaming pipeline: a source, a chain of stages and a sink, each run by
+ * its own thread. Neighbouring nodes are connected by a bounded SPSC queue
+ * of full batches and one returning the empty batches, so the batches
+ * circulate without being copied or allocated and a slow stage holds up
+ * the ones before it (backpressure) once all batches of its input are full.
+ *
+ * Every node records its busy time, the time it waited for input (starved)
+ * and for an empty output batch (blocked, the backpressure), and the depth
+ * of its input queue, see metrics().
+ */
+class stream_pipeline
+{
+public:
+    // fills out (len and n_items are 0), returns false at the end of the stream
+    typedef std::function<bool(stream_batch* out)> source_fn;
+    // turns in (which it may modify) into out (len and n_items are 0)
+    typedef std::function<void(stream_batch& in, stream_batch* out)> stage_fn;
+    // called once the input of a stage has ended, puts what the stage still
+    // holds (e.g. an incomplete block) in out, as stage_fn
+    typedef std::function<void(stream_batch* out)> finish_fn;
+    typedef std::function<void(const stream_batch& in)> sink_fn;
+
+    struct stage_metrics
+    {
+        std::string name;
+        uint64_t batches;    // batches processed
+        uint64_t bytes_in;
+        uint64_t bytes_out;
+        uint64_t items_out;
+        double busy_s;       // in the node's function
+        double starved_s;    // waiting for an input batch
+        double blocked_s;    // waiting for an empty output batch
+        uint64_t blocked;    // output batches not available right away
+        size_t max_depth;    // input queue, full batches
+        double mean_depth;   // input queue when a batch was taken
+    };
+
+    /**
+     * @param queue_depth Batches between two nodes
+     * @param batch_size  Initial buffer size of the batches in bytes
+     */
+    explicit stream_pipeline(int queue_depth = 8, size_t batch_size = 1 << 16);
+    ~stream_pipeline();
+
+    stream_pipeline(const stream_pipeline&) = delete;
+    stream_pipeline& operator=(const stream_pipeline&) = delete;
+
+    // the nodes, in stream order, before start()
+    void set_source(const char* name, source_fn source);
+    void add_stage(const char* name, stage_fn stage, finish_fn finish = nullptr);
+    void set_sink(const char* name, sink_fn sink);
+
+    /**
+     * Starts one thread per node.
+     */
+    void start();
+
+    /**
+     * Blocks until the source has ended and its last batch, and those of
+     * the finish functions of the stages, have reached the sink.
+     */
+    void wait();
+
+    /**
+     * Stops every node as soon as its current batch is done, batches still
+     * queued are dropped.
+     */
+    void stop();
+
+    /**
+     * @return The counters of every node so far, in stream order; may be
+     *         called while running
+     */
+    std::vector<stage_metrics> metrics() const;
+    void print_metrics(FILE* out) const;
+
+private:
+    enum node_kind { SOURCE, STAGE, SINK };
+
+    // a queue of full batches and the queue returning them empty
+    struct link
+    {
+        link(int depth) : full(depth), empty(depth) {}
+        spsc_queue<stream_batch*> full;
+        spsc_queue<stream_batch*> empty;
+        std::vector<std::unique_ptr<stream_batch>> batches;
+        std::atomic<bool> closed{false};  // the producer is done
+    };
+
+    struct node
+    {
+        std::string name;
+        node_kind kind;
+        source_fn source;
+        stage_fn stage;
+        finish_fn finish;
+        sink_fn sink;
+        link* in = nullptr;
+        link* out = nullptr;
+        std::thread thread;
+
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+        std::atomic<uint64_t> items_out{0};
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> starved_ns{0};
+        std::atomic<uint64_t> blocked_ns{0};
+        std::atomic<uint64_t> blocked{0};
+        std::atomic<uint64_t> depth_sum{0};
+        std::atomic<size_t> max_depth{0};
+    };
+
+    void run(node* n);
+    void finish(node* n, uint64_t seq);
+    bool take_input(node* n, stream_batch** batch);
+    bool take_output(node* n, stream_batch** batch);
+
+    int d_queue_depth;
+    size_t d_batch_size;
+    std::vector<std::unique_ptr<node>> d_nodes;
+    std::vector<std::unique_ptr<link>> d_links;
+    std::atomic<bool> d_stop{false};
+    bool d_running = false;
+};
+
+#endif /* INCLUDED_STREAM_PIPELINE_H */
@@ -0,0 +1,38 @@
+#ifndef INCLUDED_TEST_H
+#define INCLUDED_TEST_H
+
+// Minimal checks for the unit tests: a failed CHECK() prints the condition
+// and the test returns test_result() != 0.
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                       \
+    do                                                                       \
+    {                                                                        \
+        const long long va_ = (long long)(a), vb_ = (long long)(b);          \
+        if (va_ != vb_)                                                      \
+        {                                                                    \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va_, vb_); \
+            test_failures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+static inline int test_result()
+{
+    if (test_failures) fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return test_failures ? 1 : 0;
+}
+
+#endif /* INCLUDED_TEST_H */
@@ -0,0 +1,68 @@
+// ccsds_channel_manager: pushes and stats of a removed channel
+
+#include <stdint.h>
+#include <vector>
+
+#include "ccsds_rs_encoder.h"
+#include "ccsds_channel_manager.h"
+#include "test.h"
+
+static const int N_FRAMES = 6;
+
+int main()
+{
+    ccsds_rs_encoder encoder(true, true, true, false, false, 1, true);
+    const size_t cadu_len = encoder.total_frame_len();
+    std::vector<uint8_t> payload(encoder.data_len());
+    std::vector<uint8_t> stream(N_FRAMES * cadu_len);
+    for (int f = 0; f < N_FRAMES; f++)
+    {
+        for (size_t i = 0; i < payload.size(); i++) payload[i] = f + i;
+        encoder.encode(payload.data(), &stream[f * cadu_len]);
+    }
+
+    int delivered[2] = {0, 0};
+    ccsds_channel_manager manager(
+        [&](int channel, const uint8_t*, size_t, const ccsds_frame_status& status) {
+            CHECK(status.decoded);
+            delivered[channel]++;
+        },
+        1, 1000);
+    const int ch0 = manager.add_channel({});
+    const int ch1 = manager.add_channel({});
+
+    // half of the stream, ending inside a frame
+    const size_t half = N_FRAMES / 2 * cadu_len + cadu_len / 2;
+    manager.push(ch0, stream.data(), half);
+    manager.push(ch1, stream.data(), half);
+    const ccsds_frame_sync::counters_t counters = manager.sync_counters(ch0);
+    manager.remove_channel(ch0);
+    CHECK_EQ(manager.num_channels(), 1);
+
+    // the final values are kept
+    CHECK_EQ(manager.stats(ch0).bytes, half);
+    CHECK_EQ(manager.stats(ch0).frames, N_FRAMES / 2);
+    CHECK_EQ(manager.sync_counters(ch0).frames[ccsds_frame_sync::LOCK], counters.frames[ccsds_frame_sync::LOCK]);
+    CHECK_EQ(manager.sync_counters(ch0).entered[ccsds_frame_sync::LOCK], 1);
+
+    // pushes to the removed channel are ignored
+    manager.push(ch0, &stream[half], stream.size() - half);
+    const ccsds_channel_manager::channel_input inputs[] = {
+        {ch0, &stream[half], stream.size() - half},
+        {ch1, &stream[half], stream.size() - half},
+    };
+    manager.push(inputs, 2);
+    manager.remove_channel(ch0);
+    CHECK_EQ(manager.num_channels(), 1);
+
+    // the frames found before the removal are still delivered and counted
+    manager.flush();
+    CHECK_EQ(delivered[ch0], N_FRAMES / 2);
+    CHECK_EQ(delivered[ch1], N_FRAMES);
+    CHECK_EQ(manager.stats(ch0).bytes, half);
+    CHECK_EQ(manager.stats(ch0).frames, N_FRAMES / 2);
+    CHECK_EQ(manager.stats(ch0).decoded, N_FRAMES / 2);
+    CHECK_EQ(manager.stats(ch1).decoded, N_FRAMES);
+
+    return test_result();
+}
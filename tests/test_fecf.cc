@@ -0,0 +1,65 @@
+// ccsds_rs_decoder: frame and subframe counters of frames failing the FECF
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "ccsds_rs_encoder.h"
+#include "ccsds_rs_decoder.h"
+#include "crc16.h"
+#include "test.h"
+
+static const int N_INTERLEAVE = 4;
+
+static unsigned test_rand()
+{
+    static unsigned state = 12345;
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) & 0xffffff;
+}
+
+// appends a CADU of a random payload, whose FECF is broken if bad_fecf
+static uint8_t* add_frame(ccsds_rs_encoder& encoder, bool bad_fecf, std::vector<uint8_t>* stream)
+{
+    std::vector<uint8_t> payload(encoder.data_len());
+    for (auto& b : payload) b = test_rand();
+    fecf_append(payload.data(), payload.size());
+    if (bad_fecf) payload.back() ^= 0x01;
+
+    const size_t pos = stream->size();
+    stream->resize(pos + encoder.total_frame_len());
+    encoder.encode(payload.data(), &(*stream)[pos]);
+    return &(*stream)[pos + SYNC_WORD_LEN];
+}
+
+int main()
+{
+    ccsds_rs_encoder encoder(true, true, true, false, false, N_INTERLEAVE, false);
+    ccsds_rs_decoder decoder(2, true, true, true, false, false, N_INTERLEAVE, false);
+    decoder.set_fecf(true);
+
+    std::vector<uint8_t> stream;
+    std::vector<size_t> codewords;
+    const bool bad_fecf[] = {false, true, true, false};
+    for (bool bad : bad_fecf) codewords.push_back(add_frame(encoder, bad, &stream) - stream.data());
+
+    // frame 2: correctable errors, takes the slow path
+    for (int i = 0; i < 3; i++) stream[codewords[2] + 17 * i] ^= 0x5a;
+    // frame 3: RS block 0 can't be corrected, the other blocks can
+    for (int i = 0; i < 20; i++) stream[codewords[3] + N_INTERLEAVE * i] ^= 0xff;
+    stream[codewords[3] + 1] ^= 0x11;
+
+    std::vector<uint8_t> out(4 * decoder.data_len());
+    int n_out = 0;
+    decoder.find_asm_and_decode_packed(stream.data(), stream.size(), out.data(), &n_out);
+
+    CHECK_EQ(n_out, decoder.data_len());
+    CHECK_EQ(decoder.num_frames_received(), 4);
+    CHECK_EQ(decoder.num_frames_decoded(), 1);
+    CHECK_EQ(decoder.num_frames_fast_path(), 1);
+    CHECK_EQ(decoder.num_frames_fecf_failed(), 2);
+    // the good frame and the three blocks of frame 3 that decoded
+    CHECK_EQ(decoder.num_subframes_decoded(), N_INTERLEAVE + N_INTERLEAVE - 1);
+
+    return test_result();
+}
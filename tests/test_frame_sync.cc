@@ -0,0 +1,88 @@
+// ccsds_frame_sync: frame delivery and the in-place path once locked
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "frame_sync.h"
+#include "test.h"
+
+static const uint32_t ASM = 0x1acffc1d;
+static const size_t FRAME_LEN = 1275;
+static const int N_FRAMES = 200;
+
+static unsigned test_rand()
+{
+    static unsigned state = 12345;
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) & 0xffffff;
+}
+
+// ASM + frame, N_FRAMES times, shifted right by shift bits
+static std::vector<uint8_t> make_stream(int shift, std::vector<uint8_t>* frames)
+{
+    std::vector<uint8_t> stream;
+    frames->resize(N_FRAMES * FRAME_LEN);
+    for (int f = 0; f < N_FRAMES; f++)
+    {
+        for (int i = 0; i < 4; i++) stream.push_back(ASM >> (24 - 8 * i));
+        for (size_t i = 0; i < FRAME_LEN; i++)
+        {
+            (*frames)[f * FRAME_LEN + i] = test_rand();
+            stream.push_back((*frames)[f * FRAME_LEN + i]);
+        }
+    }
+    if (shift)
+    {
+        stream.push_back(0);
+        for (size_t i = stream.size() - 1; i > 0; i--)
+        {
+            stream[i] = (stream[i] >> shift) | (stream[i - 1] << (8 - shift));
+        }
+        stream[0] >>= shift;
+    }
+    return stream;
+}
+
+// feeds the stream in chunks of chunk bytes, returns the frames delivered in place
+static int run(const std::vector<uint8_t>& stream, const std::vector<uint8_t>& frames, size_t chunk)
+{
+    ccsds_frame_sync sync(ASM, 0xffffffff, 2, FRAME_LEN, false, 2, 1);
+    int n_frames = 0;
+    int n_in_place = 0;
+    for (size_t pos = 0; pos < stream.size(); pos += chunk)
+    {
+        const size_t n = stream.size() - pos < chunk ? stream.size() - pos : chunk;
+        const uint8_t* in = &stream[pos];
+        sync.process(in, n, [&](const uint8_t* frame, size_t frame_len) {
+            CHECK_EQ(frame_len, FRAME_LEN);
+            if (n_frames < N_FRAMES) CHECK(memcmp(frame, &frames[n_frames * FRAME_LEN], FRAME_LEN) == 0);
+            if (frame >= in && frame < in + n) n_in_place++;
+            n_frames++;
+        });
+    }
+    CHECK_EQ(n_frames, N_FRAMES);
+    CHECK_EQ(sync.state(), ccsds_frame_sync::LOCK);
+    CHECK_EQ(sync.counters().slips, 0);
+    return n_in_place;
+}
+
+int main()
+{
+    std::vector<uint8_t> frames;
+
+    // byte aligned, whole frames per call: every frame is delivered in place
+    std::vector<uint8_t> stream = make_stream(0, &frames);
+    CHECK_EQ(run(stream, frames, 8 * (4 + FRAME_LEN)), N_FRAMES);
+
+    // frames spanning calls are copied, the others are still in place
+    const int n_in_place = run(stream, frames, 4000);
+    CHECK(n_in_place > N_FRAMES / 2);
+    CHECK(n_in_place < N_FRAMES);
+
+    // not byte aligned: all frames are copied
+    stream = make_stream(3, &frames);
+    CHECK_EQ(run(stream, frames, 8 * (4 + FRAME_LEN)), 0);
+
+    return test_result();
+}
@@ -0,0 +1,66 @@
+// stream_pipeline with the CCSDS stages: a finite stream delivers all its frames
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "ccsds_rs_encoder.h"
+#include "ccsds_pipeline.h"
+#include "viterbi27.h"
+#include "test.h"
+
+static const int N_FRAMES = 12;
+
+int main()
+{
+    ccsds_rs_encoder encoder(true, true, true, false, false, 1, true);
+    const int frame_len = encoder.total_frame_len();
+    const int data_len = encoder.data_len();
+
+    // CADUs back to back, rate 1/2 coded, noiseless BPSK
+    std::vector<uint8_t> payloads(N_FRAMES * data_len), cadus(N_FRAMES * frame_len);
+    for (int f = 0; f < N_FRAMES; f++)
+    {
+        for (int j = 0; j < data_len; j++) payloads[f * data_len + j] = f * 7 + j;
+        encoder.encode(&payloads[f * data_len], &cadus[f * frame_len]);
+    }
+    const int rate_12[] = {1};
+    std::vector<uint8_t> symbols(cadus.size() * 16);
+    unsigned char encstate = 0;
+    symbols.resize(encode27(&encstate, symbols.data(), cadus.data(), cadus.size(), rate_12, rate_12, 1));
+    std::vector<float> samples(symbols.size());
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = symbols[i] ? -1.0f : 1.0f;
+
+    ccsds_correlator correlator(0x1acffc1d, 0xffffffff, 2, frame_len - SYNC_WORD_LEN);
+    ccsds_rs_decoder decoder(0, true, true, true, false, false, 1, true);
+    stream_pipeline pipeline(4, 4096);
+    const size_t chunk = 1000;  // samples per source batch
+    size_t pos = 0;
+    std::vector<uint8_t> out;
+    uint32_t n_out = 0;
+    pipeline.set_source("source", [&](stream_batch* batch) {
+        if (pos >= samples.size()) return false;
+        const size_t n = samples.size() - pos < chunk ? samples.size() - pos : chunk;
+        memcpy(batch->grow(n * sizeof(float)), &samples[pos], n * sizeof(float));
+        batch->len = n * sizeof(float);
+        pos += n;
+        return true;
+    });
+    pipeline.add_stage("soft demod", make_soft_demod_stage(rate_12, rate_12, 1));
+    stream_pipeline::finish_fn viterbi_finish;
+    stream_pipeline::stage_fn viterbi = make_viterbi_stage(&viterbi_finish);
+    pipeline.add_stage("viterbi", viterbi, viterbi_finish);
+    pipeline.add_stage("correlator", make_correlator_stage(&correlator));
+    pipeline.add_stage("rs decode", make_rs_decode_stage(&decoder));
+    pipeline.set_sink("sink", [&](const stream_batch& in) {
+        out.insert(out.end(), in.data(), in.data() + in.len);
+        n_out += in.n_items;
+    });
+    pipeline.start();
+    pipeline.wait();
+
+    CHECK_EQ(n_out, N_FRAMES);
+    CHECK(out == payloads);
+
+    return test_result();
+}
@@ -0,0 +1,112 @@
+// TM/AOS transfer frame headers and virtual channel demultiplexing
+
+#include "transfer_frame.h"
+
+#include "crc16.h"
+
+bool parse_transfer_frame(const uint8_t* frame, size_t len, const transfer_frame_config& config,
+                          transfer_frame_view* view)
+{
+    if (len < TF_PRIMARY_HEADER_LEN || len > UINT16_MAX) return false;
+    // version numbers 1 (TM) and 2 (AOS), coded as 0 and 1
+    if ((frame[0] >> 6) != (config.type == TF_TM ? 0 : 1)) return false;
+
+    view->frame = frame;
+    view->len = len;
+    view->type = config.type;
+    view->has_m_pdu = false;
+
+    size_t head = TF_PRIMARY_HEADER_LEN;
+    size_t tail = config.fecf ? FECF_LEN : 0;
+    if (config.type == TF_TM)
+    {
+        view->has_ocf = frame[1] & 0x1;
+        // the secondary header starts with its length - 1
+        if ((frame[4] & 0x80) && len > head) head += (frame[head] & 0x3f) + 1;
+    }
+    else
+    {
+        view->has_ocf = config.aos_ocf;
+        head += (config.aos_fhec ? 2 : 0) + config.aos_insert_zone_len;
+        view->has_m_pdu = config.aos_packets;
+    }
+    if (view->has_ocf) tail += TF_OCF_LEN;
+    if (head + tail + (view->has_m_pdu ? 2 : 0) > len) return false;
+
+    view->data_off = head;
+    view->data_len = len - head - tail;
+    return true;
+}
+
+vc_demux::vc_demux(const transfer_frame_config& config)
+    : d_config(config), d_queues(TF_MAX_VCID + 1)
+{
+}
+
+// a count other than the expected one is a gap, whatever it skipped lost
+void vc_demux::follow_count(uint32_t count, uint32_t modulus, bool* seen, uint32_t* next_count, vc_stats* stats)
+{
+    if (*seen && count != *next_count)
+    {
+        stats->gaps++;
+        stats->lost += (count - *next_count) & (modulus - 1);
+    }
+    *seen = true;
+    *next_count = (count + 1) & (modulus - 1);
+}
+
+bool vc_demux::push(const uint8_t* frame, size_t len)
+{
+    d_counters.frames++;
+    transfer_frame_view view;
+    if (!parse_transfer_frame(frame, len, d_config, &view) || (d_config.scid >= 0 && view.scid() != d_config.scid))
+    {
+        d_counters.rejected++;
+        return false;
+    }
+
+    // the master channel counts every frame, idle ones included
+    if (d_config.type == TF_TM)
+    {
+        follow_count(view.mc_count(), 1u << 8, &d_mc_seen, &d_mc_next, &d_counters.mc);
+        d_counters.mc.frames++;
+    }
+
+    // AOS VC 63 carries only idle frames, whose counts aren't followed;
+    // idle data on another VC still counts on that VC
+    const int vcid = view.vcid();
+    if (d_config.type == TF_AOS && vcid == AOS_IDLE_VCID)
+    {
+        d_counters.idle++;
+        return false;
+    }
+    vc_state& vc = d_vcs[vcid];
+    follow_count(view.vc_count(), view.vc_count_modulus(), &vc.seen, &vc.next_count, &vc.stats);
+    if (view.first_header_pointer() == TF_FHP_IDLE)
+    {
+        d_counters.idle++;
+        return false;
+    }
+    vc.stats.frames++;
+    d_queues[vcid].push_back(view);
+    return true;
+}
+
+int vc_demux::push_frames(const uint8_t* frames, size_t n_bytes, size_t frame_len)
+{
+    int n_queued = 0;
+    for (size_t pos = 0; pos + frame_len <= n_bytes; pos += frame_len)
+    {
+        n_queued += push(&frames[pos], frame_len);
+    }
+    return n_queued;
+}
+
+bool vc_demux::pop(int vcid, transfer_frame_view* view)
+{
+    std::deque<transfer_frame_view>& q = d_queues[vcid];
+    if (q.empty()) return false;
+    *view = q.front();
+    q.pop_front();
+    return true;
+}
@@ -0,0 +1,196 @@
+#ifndef INCLUDED_TRANSFER_FRAME_H
+#define INCLUDED_TRANSFER_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <vector>
+
+/*
+ * TM (CCSDS 132.0-B) and AOS (CCSDS 732.0-B) transfer frames, the payloads
+ * of the decoded codewords. The primary headers:
+ *
+ *   TM   version:2 SCID:10 VCID:3 OCF flag:1 | MC count:8 | VC count:8 |
+ *        secondary header flag:1 sync:1 packet order:1 segment length:2
+ *        first header pointer:11
+ *   AOS  version:2 SCID:8 VCID:6 | VC count:24 | replay:1 count usage:1
+ *        spare:2 count cycle:4 | [FHEC:16] [insert zone]
+ *
+ * followed by the data field, the optional OCF (4 bytes) and FECF (2 bytes).
+ * The AOS packet service (M_PDU) starts the data field with 5 spare bits and
+ * the 11-bit first header pointer.
+ */
+
+#define TF_PRIMARY_HEADER_LEN 6
+#define TF_OCF_LEN 4
+#define TF_FHP_NO_PACKET 0x7ff  // no packet starts in the frame
+#define TF_FHP_IDLE 0x7fe       // the data field holds idle data only
+#define TF_MAX_VCID 63
+#define AOS_IDLE_VCID 63
+
+enum transfer_frame_type
+{
+    TF_TM,
+    TF_AOS,
+};
+
+// the parts of the frame layout that aren't signaled in the frame itself
+struct transfer_frame_config
+{
+    transfer_frame_type type = TF_TM;
+    bool fecf = false;             // frames end with a FECF
+    int scid = -1;                 // frames of other spacecraft are dropped, -1 for any
+    // AOS only, a TM frame signals its OCF and secondary header
+    bool aos_fhec = false;         // header error control after the primary header
+    int aos_insert_zone_len = 0;
+    bool aos_ocf = false;
+    bool aos_packets = true;       // the data field is an M_PDU (packet service)
+};
+
+/**
+ * Fields of a transfer frame, read from the frame bytes in place on each
+ * call; the frame isn't copied and must outlive the view.
+ */
+struct transfer_frame_view
+{
+    const uint8_t* frame;
+    uint16_t len;
+    uint8_t type;        // transfer_frame_type
+    bool has_ocf;
+    bool has_m_pdu;      // AOS packet service
+    uint16_t data_off;   // data field
+    uint16_t data_len;
+
+    int version() const { return frame[0] >> 6; }
+    int scid() const
+    {
+        return type == TF_TM ? ((frame[0] & 0x3f) << 4) | (frame[1] >> 4) : ((frame[0] & 0x3f) << 2) | (frame[1] >> 6);
+    }
+    int vcid() const { return type == TF_TM ? (frame[1] >> 1) & 0x7 : frame[1] & 0x3f; }
+
+    // master channel frame count, TM only (-1 for AOS)
+    int mc_count() const { return type == TF_TM ? frame[2] : -1; }
+
+    // virtual channel frame count, the AOS count extended by the count
+    // cycle if its usage flag is set
+    uint32_t vc_count() const
+    {
+        if (type == TF_TM) return frame[3];
+        const uint32_t count = ((uint32_t)frame[2] << 16) | (frame[3] << 8) | frame[4];
+        return (frame[5] & 0x40) ? ((uint32_t)(frame[5] & 0x0f) << 24) | count : count;
+    }
+    uint32_t vc_count_modulus() const
+    {
+        return type == TF_TM ? 1u << 8 : (frame[5] & 0x40) ? 1u << 28 : 1u << 24;
+    }
+
+    // TM data field status
+    bool secondary_header() const { return type == TF_TM && (frame[4] & 0x80); }
+    bool sync_flag() const { return type == TF_TM && (frame[4] & 0x40); }
+    // AOS signaling field
+    bool replay() const { return type == TF_AOS && (frame[5] & 0x80); }
+
+    /**
+     * @return First header pointer, TF_FHP_NO_PACKET if the frame carries
+     *         no packet service
+     */
+    uint16_t first_header_pointer() const
+    {
+        if (type == TF_TM) return sync_flag() ? TF_FHP_NO_PACKET : ((frame[4] & 0x7) << 8) | frame[5];
+        if (!has_m_pdu) return TF_FHP_NO_PACKET;
+        return ((frame[data_off] & 0x7) << 8) | frame[data_off + 1];
+    }
+
+    const uint8_t* data_field() const { return &frame[data_off]; }
+
+    // the data field without the M_PDU header, which the first header
+    // pointer indexes
+    const uint8_t* packet_zone() const { return &frame[data_off + (has_m_pdu ? 2 : 0)]; }
+    size_t packet_zone_len() const { return data_len - (has_m_pdu ? 2 : 0); }
+
+    const uint8_t* ocf() const { return has_ocf ? &frame[data_off + data_len] : nullptr; }
+};
+
+/**
+ * Fills view for the frame of len bytes.
+ *
+ * @return False if the frame is too short for its headers, or not a
+ *         version 1 (TM) or 2 (AOS) frame as configured
+ */
+bool parse_transfer_frame(const uint8_t* frame, size_t len, const transfer_frame_config& config,
+                          transfer_frame_view* view);
+
+/**
+ * Sorts decoded transfer frames into one queue per virtual channel, as
+ * views into the frames: nothing is copied, so the frames must stay valid
+ * until they are popped (e.g. the payloads of a batch, or frame_ring slots
+ * released once their VCs are drained). Idle frames (AOS VC 63, or a first
+ * header pointer of TF_FHP_IDLE) and frames of other spacecraft are dropped
+ * right away. The frame counts of each VC (and the TM master channel) are
+ * followed, every discontinuity is counted as a gap and the frames it skips
+ * as lost.
+ */
+class vc_demux
+{
+public:
+    struct vc_stats
+    {
+        uint64_t frames;  // queued (for the master channel: counted)
+        uint64_t gaps;    // frame count discontinuities
+        uint64_t lost;    // frames skipped by the gaps
+    };
+
+    struct counters_t
+    {
+        uint64_t frames;    // pushed
+        uint64_t idle;      // dropped as idle
+        uint64_t rejected;  // dropped as malformed or of another spacecraft
+        vc_stats mc;        // TM master channel count
+    };
+
+    explicit vc_demux(const transfer_frame_config& config);
+
+    /**
+     * @return True if the frame was queued
+     */
+    bool push(const uint8_t* frame, size_t len);
+
+    /**
+     * Pushes n_bytes / frame_len frames stored back to back, e.g. the output
+     * of ccsds_rs_decoder::find_asm_and_decode_packed().
+     *
+     * @return Number of frames queued
+     */
+    int push_frames(const uint8_t* frames, size_t n_bytes, size_t frame_len);
+
+    /**
+     * The oldest queued frame of the VC.
+     *
+     * @return False if there is none
+     */
+    bool pop(int vcid, transfer_frame_view* view);
+
+    size_t queued(int vcid) const { return d_queues[vcid].size(); }
+    const vc_stats& stats(int vcid) const { return d_vcs[vcid].stats; }
+    const counters_t& counters() const { return d_counters; }
+    const transfer_frame_config& config() const { return d_config; }
+
+private:
+    struct vc_state
+    {
+        vc_stats stats;
+        bool seen;
+        uint32_t next_count;
+    };
+
+    static void follow_count(uint32_t count, uint32_t modulus, bool* seen, uint32_t* next_count, vc_stats* stats);
+
+    transfer_frame_config d_config;
+    vc_state d_vcs[TF_MAX_VCID + 1] = {};
+    std::vector<std::deque<transfer_frame_view>> d_queues;
+    counters_t d_counters = {};
+    bool d_mc_seen = false;
+    uint32_t d_mc_next = 0;
+};
+
+#endif /* INCLUDED_TRANSFER_FRAME_H */